@@ -1,13 +1,31 @@
 #pragma once
 
-#include "AbstractProtocol.hpp"
+#include "AbstractCoroutineProtocol.hpp"
+#include "HistoryBacklog.hpp"
 
-class AS3_Protocol final : public AbstractProtocol
+class AS3_Protocol final : public AbstractCoroutineProtocol
 {
+private:
+    std::uint64_t imei;
+    HistoryUpload upload;
+    HistoryBacklog backlog; // kept across reconnects
+
+private:
+    void fill_backlog();
+    Task upload_history();
+
+protected:
+    Task session() override;
+
 public:
     AS3_Protocol();
+    explicit AS3_Protocol(std::uint64_t _imei, HistoryUpload _upload = {});
     ~AS3_Protocol() override = default;
 
 public:
     void handler_loop(int _socket_fd) override;
-};
\ No newline at end of file
+    [[nodiscard]] ProtocolId protocol_id() const override { return ProtocolId::AS3; }
+    [[nodiscard]] SocketOptions socket_options() const override;
+    /* bytes per backlog record, for sizing a HistoryJournal */
+    [[nodiscard]] static std::size_t history_record_size();
+};
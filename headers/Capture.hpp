@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string>
+#include <sys/uio.h>
+
+
+#define CAPTURE_MAGIC                   "TCPCAP01"
+#define CAPTURE_VERSION                 (1U)
+#define CAPTURE_RECORD_ALIGN            (8U)
+
+
+enum class CaptureDirection : uint8_t
+{
+    SENT = 0,
+    RECEIVED = 1
+};
+
+/* file layout: CaptureFileHeader, then records until a zero size or end of file */
+struct CaptureFileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_header_size;
+};
+
+struct CaptureRecordHeader
+{
+    uint64_t timestamp_ns; // CLOCK_REALTIME
+    uint32_t session_id;
+    uint32_t size;         // payload bytes, padded to CAPTURE_RECORD_ALIGN in the file
+    uint16_t protocol_id;
+    uint8_t direction;
+    uint8_t reserved[5];
+};
+
+static_assert(sizeof(CaptureFileHeader) == 16);
+static_assert(sizeof(CaptureRecordHeader) == 24);
+
+
+/*
+ * Append-only binary capture of protocol frames. The file is mapped into
+ * a reserved address range and grows in fixed steps; writers reserve
+ * space with one atomic add and copy straight into the mapping, so the
+ * page cache does the disk I/O and the event loop never blocks on write(2).
+ * Only growing the file takes a lock. Space is reserved only once it is
+ * mapped; a capture that cannot grow is disabled with one log line and
+ * never fails the session that records.
+ *
+ * open() and close() run while no session records, before the sessions
+ * start and after they stopped (main() does both), so record() needs no
+ * reference count on the hot path.
+ */
+class Capture
+{
+private:
+    int file_fd = -1;
+    uint8_t* base = nullptr;
+    size_t reserved_size = 0;
+
+    std::atomic<size_t> write_offset{0};
+    std::atomic<size_t> mapped_size{0};
+    std::mutex grow_mutex;
+    std::atomic<bool> failed{false};
+
+    static std::atomic<Capture*> active;
+
+private:
+    void grow(size_t _size);
+    void append(CaptureDirection _direction, uint32_t _session_id, uint16_t _protocol_id, const iovec* _parts, size_t _count);
+
+public:
+    /* start capturing to _path, the file is truncated; call before sessions start */
+    static void open(const std::string& _path);
+    /* call after all sessions stopped */
+    static void close();
+    [[nodiscard]] static bool enabled() { return active.load(std::memory_order_relaxed) != nullptr; }
+
+    static void record(CaptureDirection _direction, uint32_t _session_id, uint16_t _protocol_id, const iovec* _parts, size_t _count);
+
+public:
+    explicit Capture(const std::string& _path);
+    Capture(const Capture&) = delete;
+    Capture& operator=(const Capture&) = delete;
+    ~Capture();
+};
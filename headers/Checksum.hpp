@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+
+/*
+ * The "crc" of the device protocols: a byte sum truncated to 16 bits.
+ * Large buffers are summed 16 or 32 bytes at a time with psadbw (SSE2,
+ * or AVX2 when the CPU has it, chosen once at runtime). The running form
+ * takes the bytes in any number of pieces, a packet can be summed while
+ * it is being built.
+ */
+class Checksum
+{
+private:
+    uint64_t sum = 0;
+
+public:
+    void update(const uint8_t* _data, size_t _size);
+    void update(const uint8_t _byte) { sum += _byte; }
+    [[nodiscard]] uint16_t value() const { return static_cast<uint16_t>(sum); }
+
+    static uint16_t compute(const uint8_t* _data, size_t _size);
+    /* name of the kernel in use: "avx2", "sse2" or "scalar" */
+    static const char* kernel();
+};
@@ -0,0 +1,189 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+#include <memory>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <future>
+#include <netinet/in.h>
+
+#include "AbstractProtocol.hpp"
+#include "TimerWheel.hpp"
+#include "Reconnect.hpp"
+#include "Resolver.hpp"
+#include "SourceBinding.hpp"
+#include "SocketOptions.hpp"
+#ifdef IO_URING
+#include "IoUring.hpp"
+#endif // IO_URING
+
+
+#define CONNECTION_MANAGER_MAX_EVENTS       1024U
+#define CONNECTION_MANAGER_IDLE_WAIT_MS     1000
+#define CONNECTION_MANAGER_CONNECT_TIMEOUT_MS   10000U
+#define CONNECTION_MANAGER_WAKE_ID          UINT64_MAX // event data of the wake-up eventfd
+
+#ifdef IO_URING
+#define CONNECTION_MANAGER_RING_ENTRIES     4096U
+#define CONNECTION_MANAGER_IO_BUFFER_SIZE   2048U
+#endif // IO_URING
+
+
+class ConnectionManager
+{
+public:
+    using ProtocolFactory = std::function<std::shared_ptr<AbstractProtocol>(size_t _session_id)>;
+
+    /* delay of a session connect from run() start, must not decrease with the index */
+    using RampSchedule = std::function<AbstractProtocol::clock::duration(size_t _index, size_t _count)>;
+
+    struct Stats
+    {
+        size_t connects = 0;            // completed connects
+        size_t connect_failures = 0;
+        size_t closes = 0;              // of connected sessions, each session ends once as a failure or a close
+        size_t reconnects = 0;          // reconnect attempts started
+    };
+
+    using ReportCallback = std::function<void(const Stats& _stats, size_t _active)>;
+
+    /* called on the loop thread every iteration and after wake() */
+    using InboxHook = std::function<void()>;
+
+private:
+    enum class SessionState
+    {
+        CONNECTING,
+        CONNECTED,
+        CLOSED
+    };
+
+    struct Session
+    {
+        size_t id = 0;
+        int socket_fd = -1;
+        SessionState state = SessionState::CLOSED;
+        uint32_t events = 0;
+        TimerNode timer;                                    // linked into the wheel, sessions never move
+        AbstractProtocol::clock::time_point timer_deadline{};
+        AbstractProtocol::clock::time_point connected_at{};
+        size_t address = 0;                                 // server address to use, moves on after a failed connect
+        unsigned attempts = 0;                              // reconnects since the last stable connection
+        bool reconnect_pending = false;                     // the timer reopens the session
+        std::shared_ptr<AbstractProtocol> protocol;
+#ifdef IO_URING
+        uint32_t generation = 0;
+        bool recv_pending = false;
+        bool send_pending = false;
+#endif // IO_URING
+    };
+
+private:
+    std::string host;
+    uint16_t port;
+    ProtocolFactory factory;
+
+    /* resolved once per run, refreshed in the background after the resolver ttl */
+    AddressList addresses;
+    AbstractProtocol::clock::time_point addresses_refresh{};
+    std::shared_future<AddressList> pending_addresses;
+
+#ifdef IO_URING
+    IoUring ring;
+    std::vector<uint8_t> io_buffers;
+    size_t buffer_slots = 0;
+    bool fixed_buffers = false;
+#else
+    int epoll_fd = -1;
+#endif // IO_URING
+    int wake_fd = -1;
+    std::atomic<bool> running{false};
+    bool persistent = false;
+    size_t capacity = 0;
+    InboxHook inbox;
+
+    /* deque keeps sessions in place while the wheel links their timers */
+    std::deque<Session> sessions;
+    TimerWheel timers;
+    AbstractProtocol::clock::time_point timer_origin = AbstractProtocol::clock::now(); // tick 0 of the wheel
+
+    size_t open_sessions = 0;
+
+    /* reconnect */
+    ReconnectPolicy reconnect;
+    size_t pending_reconnects = 0;
+
+    /* on top of the protocol profiles */
+    SocketOptions socket_options;
+
+    /* ramp-up */
+    RampSchedule ramp;
+    size_t next_open = 0;
+    AbstractProtocol::clock::time_point start_time{};
+
+    /* statistics */
+    Stats counters;
+    ReportCallback report;
+    AbstractProtocol::clock::duration report_interval{};
+    AbstractProtocol::clock::time_point next_report{};
+
+private:
+    void push_session(std::shared_ptr<AbstractProtocol> _protocol);
+    void clear_wake();
+    void refresh_addresses();
+    void open_session(Session& session);
+    void close_session(Session& session, const std::string& reason);
+    void start_session(Session& session);
+    void schedule_reconnect(Session& session);
+    void finish_connect(Session& session);
+    void update_session(Session& session);
+    void poll_events(int wait_ms);
+    void run_timers();
+    [[nodiscard]] uint64_t to_tick(AbstractProtocol::clock::time_point time_point) const;
+    void open_due_sessions();
+    void run_report();
+    [[nodiscard]] AbstractProtocol::clock::time_point open_time(size_t index) const;
+#ifdef IO_URING
+    void setup_buffers();
+    void arm_wake();
+    void submit_io(Session& session);
+    void handle_completion(const io_uring_cqe& cqe);
+    [[nodiscard]] uint8_t* rx_slot(const Session& session) { return io_buffers.data() + session.id * 2 * CONNECTION_MANAGER_IO_BUFFER_SIZE; }
+    [[nodiscard]] uint8_t* tx_slot(const Session& session) { return rx_slot(session) + CONNECTION_MANAGER_IO_BUFFER_SIZE; }
+#else
+    void handle_events(Session& session, uint32_t events);
+#endif // IO_URING
+    [[nodiscard]] int next_wait_ms() const;
+
+public:
+    void add_sessions(size_t count);
+    /* loop thread only (before run or from the inbox hook), keeps the protocol session id */
+    void add_session(std::shared_ptr<AbstractProtocol> _protocol);
+    void set_ramp(RampSchedule _ramp) { ramp = std::move(_ramp); }
+    /* reopen closed and failed sessions, connects wait for TokenBucket::connects() */
+    void set_reconnect(const ReconnectPolicy& _reconnect) { reconnect = _reconnect; }
+    /* options set here replace those of each protocol profile */
+    void set_socket_options(const SocketOptions& _socket_options) { socket_options = _socket_options; }
+    void set_report(ReportCallback _report, AbstractProtocol::clock::duration _interval);
+    /* keep running without sessions until stop(), for loops fed through the inbox */
+    void set_persistent(const bool _persistent) { persistent = _persistent; }
+    void set_inbox(InboxHook _inbox) { inbox = std::move(_inbox); }
+    /* sessions to size io_uring buffers for, when sessions are added while running */
+    void set_capacity(const size_t _capacity) { capacity = _capacity; }
+
+    void run();
+    void stop();
+    void wake();
+
+    [[nodiscard]] size_t size() const { return sessions.size(); }
+    [[nodiscard]] size_t active() const { return open_sessions; }
+    [[nodiscard]] const Stats& stats() const { return counters; }
+
+public:
+    /* _host: name or address literal, resolved when run() starts */
+    ConnectionManager(std::string _host, uint16_t _port, ProtocolFactory _factory);
+    ~ConnectionManager();
+};
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+
+#include "ConnectionManager.hpp"
+#include "ShardedScheduler.hpp"
+#include "HistoryBacklog.hpp"
+
+
+#define FLEET_DEFAULT_FIRST_IMEI            (862686042898620ULL)
+#define FLEET_DEFAULT_RAMP_STEPS            (10U)
+#define FLEET_SPIKE_BASE_PERCENT            (50U) // share of a spike fleet ramped linearly before the burst
+#define FLEET_REPORT_INTERVAL_MS            (1000U)
+#define FLEET_LATENCY_REPORT_EVERY          (10U) // fleet reports per latency report
+
+
+enum class FleetProtocol
+{
+    AS3,
+    INTERCOM,
+    SCALES
+};
+
+enum class RampProfile
+{
+    LINEAR, // even connect rate over the ramp time
+    STEP,   // equal batches at equal intervals
+    SPIKE   // linear base load, then the rest at once at the end of the ramp
+};
+
+struct FleetConfig
+{
+    size_t devices = 0;
+    uint64_t first_imei = FLEET_DEFAULT_FIRST_IMEI; // device i gets first_imei + i
+    std::vector<std::pair<FleetProtocol, unsigned>> mix{{FleetProtocol::AS3, 1}}; // protocol weights
+    RampProfile ramp = RampProfile::LINEAR;
+    std::chrono::milliseconds ramp_time{0};
+    unsigned ramp_steps = FLEET_DEFAULT_RAMP_STEPS;
+    size_t workers = 1; // more than one runs the fleet on a ShardedScheduler
+    ReconnectPolicy reconnect;
+    SocketOptions socket_options; // on top of each protocol profile
+    HistoryUpload history;        // per AS3 device
+};
+
+
+/*
+ * Load generator: a population of simulated devices with consecutive
+ * IMEIs, interleaved by protocol weight and connected along a ramp
+ * profile. Prints active sessions and new connects once per second and
+ * the round-trip latency percentiles every ten seconds, with the history
+ * ingest rate the server sustained while AS3 devices flushed their backlogs.
+ * With several workers this thread feeds the ramp into the shards.
+ */
+class Fleet
+{
+private:
+    FleetConfig config;
+    unsigned total_weight = 0;
+
+    /* one of them runs the fleet */
+    std::unique_ptr<ConnectionManager> manager;
+    std::unique_ptr<ShardedScheduler> scheduler;
+
+    size_t last_connects = 0;
+    size_t reports = 0;
+    uint64_t last_history = 0;
+    size_t history_reports = 0; // reports with history acked
+
+private:
+    [[nodiscard]] std::shared_ptr<AbstractProtocol> create_device(size_t _index) const;
+    [[nodiscard]] AbstractProtocol::clock::duration ramp_delay(size_t _index, size_t _count) const;
+    void print_report(const ConnectionManager::Stats& _stats, size_t _active);
+    void run_sharded();
+
+public:
+    /* "as3:3,intercom:1" */
+    static std::vector<std::pair<FleetProtocol, unsigned>> parse_mix(const std::string& _mix);
+    /* "linear", "step" or "spike" */
+    static RampProfile parse_ramp(const std::string& _ramp);
+
+    void run();
+
+public:
+    Fleet(const std::string& _host, uint16_t _port, FleetConfig _config);
+    Fleet(const Fleet&) = delete;
+    Fleet& operator=(const Fleet&) = delete;
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "HistoryJournal.hpp"
+
+
+#define HISTORY_BACKLOG_INITIAL_RECORDS     (64U)
+
+
+/* history a simulated device kept while offline and how it uploads it */
+struct HistoryUpload
+{
+    size_t backlog = 0; // events appended at start
+    size_t window = 1;  // packets in flight before the oldest ack, 1 - stop and wait
+    std::shared_ptr<HistoryJournal> journal; // keeps the backlog on disk, in memory without
+    size_t slot = 0;                         // of this device in the journal
+};
+
+
+/*
+ * Unsent history of one device: fixed-size records (encoded packets) in
+ * a ring, oldest first. A record stays until its ack arrives, so records
+ * in flight on a lost connection are sent again after the reconnect.
+ * peek() returns contiguous runs, a window of packets goes out in one send.
+ *
+ * In memory the ring grows; in a journal slot it has a fixed capacity and
+ * a push into a full ring overwrites the oldest record, as a device with
+ * a full flash would. Records are not pushed during an upload.
+ */
+class HistoryBacklog
+{
+private:
+    size_t record_size;
+    size_t capacity;                        // records
+    std::vector<uint8_t> storage;           // in memory
+    std::shared_ptr<HistoryJournal> journal;
+    uint8_t* records;                       // storage or the journal slot
+    HistoryRing local{};
+    HistoryRing* mapped = nullptr;
+
+    [[nodiscard]] HistoryRing& ring() { return mapped != nullptr ? *mapped : local; }
+    [[nodiscard]] const HistoryRing& ring() const { return mapped != nullptr ? *mapped : local; }
+    [[nodiscard]] uint8_t* record(uint64_t _sequence) const { return records + (_sequence % capacity) * record_size; }
+    void grow();
+
+public:
+    void push(std::span<const uint8_t> _record);
+    /* up to _max records from _offset records after the oldest, stops at the end of the ring */
+    [[nodiscard]] std::span<const uint8_t> peek(size_t _offset, size_t _max) const;
+    /* drop the _count oldest records, after their acks */
+    void pop(size_t _count);
+
+    [[nodiscard]] size_t size() const { return ring().end - ring().first; }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+
+public:
+    /* in memory */
+    explicit HistoryBacklog(size_t _record_size);
+    /* in slot _slot of _journal, resuming what it holds */
+    HistoryBacklog(std::shared_ptr<HistoryJournal> _journal, size_t _slot, size_t _record_size);
+    HistoryBacklog(const HistoryBacklog&) = delete;
+    HistoryBacklog& operator=(const HistoryBacklog&) = delete;
+    HistoryBacklog(HistoryBacklog&&) = default;
+    HistoryBacklog& operator=(HistoryBacklog&&) = default;
+};
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+
+#define HISTORY_JOURNAL_MAGIC               "TCPHIS01"
+#define HISTORY_JOURNAL_VERSION             (1U)
+#define HISTORY_JOURNAL_SLOT_ALIGN          (64U)   // slots of devices on different threads share no cache line
+#define HISTORY_JOURNAL_DEFAULT_CAPACITY    (4096U) // records per device
+
+
+/* file layout: HistoryJournalHeader padded to HISTORY_JOURNAL_SLOT_ALIGN, then one slot per device */
+struct HistoryJournalHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    uint64_t capacity;  // records per slot
+    uint64_t slots;
+};
+
+/*
+ * Slot: HistoryRing, then capacity records. first and end only grow, the
+ * record at sequence n is at n % capacity; every change commits with one
+ * aligned 8-byte store, a process killed in between loses at most the
+ * record being written.
+ */
+struct HistoryRing
+{
+    uint64_t first; // oldest record
+    uint64_t end;   // one past the newest
+};
+
+static_assert(sizeof(HistoryJournalHeader) == 32);
+static_assert(sizeof(HistoryRing) == 16);
+
+
+/*
+ * Shared file of per-device history rings for long soak tests. The whole
+ * file is one shared mapping, so a fleet of any size costs one descriptor
+ * and one mapping, memory is the page cache, and the backlog survives a
+ * restart of the process. Opening an existing journal keeps its records;
+ * more slots extend it, a different record size or capacity is an error.
+ * The file is locked, one process at a time.
+ */
+class HistoryJournal
+{
+private:
+    int file_fd = -1;
+    uint8_t* base = nullptr;
+    size_t mapped_size = 0;
+    size_t slot_size = 0;
+
+    [[nodiscard]] const HistoryJournalHeader& header() const { return *reinterpret_cast<const HistoryJournalHeader*>(base); }
+
+public:
+    [[nodiscard]] size_t record_size() const { return header().record_size; }
+    [[nodiscard]] size_t capacity() const { return header().capacity; }
+    [[nodiscard]] size_t slots() const { return header().slots; }
+
+    /* ring and records of slot _index */
+    [[nodiscard]] HistoryRing& ring(size_t _index) const;
+    [[nodiscard]] uint8_t* records(size_t _index) const;
+
+public:
+    /* open or create _path with at least _slots rings of _capacity records */
+    HistoryJournal(const std::string& _path, size_t _slots, size_t _capacity, size_t _record_size);
+    HistoryJournal(const HistoryJournal&) = delete;
+    HistoryJournal& operator=(const HistoryJournal&) = delete;
+    ~HistoryJournal();
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <string>
+
 #include "AbstractProtocol.hpp"
 
 struct PingPacket
@@ -18,10 +20,36 @@ struct PingPacket
 
 class IntercomAppProtocol final : public AbstractProtocol
 {
+private:
+    enum class State
+    {
+        HANDSHAKE,
+        PING,
+        IDLE
+    };
+
+    State state = State::HANDSHAKE;
+    std::string imei;
+    clock::time_point ping_sent{};
+
+private:
+    void send_ping();
+
+protected:
+    void on_message(const uint8_t* data, size_t size) override;
+    void on_timer() override;
+
 public:
-    IntercomAppProtocol() = default;
+    IntercomAppProtocol();
+    explicit IntercomAppProtocol(std::string _imei);
     ~IntercomAppProtocol() override = default;
 
 public:
     void handler_loop(int _socket_fd) override;
-};
\ No newline at end of file
+    [[nodiscard]] ProtocolId protocol_id() const override { return ProtocolId::INTERCOM; }
+    [[nodiscard]] SocketOptions socket_options() const override;
+
+public:
+    [[nodiscard]] bool supports_events() const override { return true; }
+    void on_connected(int _socket_fd) override;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#ifdef IO_URING
+
+#include <string>
+#include <linux/io_uring.h>
+#include <sys/uio.h>
+
+
+/*
+ * Minimal io_uring wrapper over the raw syscalls (no liburing dependency).
+ * SQEs are only queued by get_sqe(), every queued SQE goes to the kernel
+ * with the next submit_and_wait() call.
+ */
+class IoUring
+{
+private:
+    int ring_fd = -1;
+
+    /* submission queue */
+    void* sq_ring = nullptr;
+    size_t sq_ring_size = 0;
+    unsigned* sq_head = nullptr;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned sq_entries = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqes_size = 0;
+    unsigned sq_local_tail = 0;
+
+    /* completion queue */
+    void* cq_ring = nullptr;
+    size_t cq_ring_size = 0;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    unsigned to_submit = 0;
+
+private:
+    int enter(unsigned submit, unsigned wait_nr, int timeout_ms);
+
+public:
+    io_uring_sqe* get_sqe();
+    unsigned submit_and_wait(unsigned wait_nr, int timeout_ms);
+    bool pop_completion(io_uring_cqe& cqe);
+
+    bool register_buffers(const iovec* buffers, unsigned count);
+
+    [[nodiscard]] unsigned pending() const { return to_submit; }
+
+public:
+    explicit IoUring(unsigned _entries);
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+    ~IoUring();
+};
+
+#endif // IO_URING
@@ -4,10 +4,15 @@
 
 class LV_Protocol final : public AbstractProtocol
 {
+private:
+    uint64_t imei;
+
 public:
-    LV_Protocol() = default;
+    LV_Protocol();
+    explicit LV_Protocol(uint64_t _imei);
     ~LV_Protocol() override = default;
 
 public:
     void handler_loop(int _socket_fd) override;
+    [[nodiscard]] ProtocolId protocol_id() const override { return ProtocolId::LV; }
 };
\ No newline at end of file
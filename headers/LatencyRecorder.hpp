@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+
+#define LATENCY_SUB_BUCKET_BITS         (7U)  // 128 sub-buckets, values within 1/64 (~1.6%)
+#define LATENCY_MAX_VALUE_BITS          (36U) // microseconds, about 19 hours
+#define LATENCY_SUB_BUCKETS             (1U << LATENCY_SUB_BUCKET_BITS)
+#define LATENCY_BUCKETS                 (LATENCY_MAX_VALUE_BITS - LATENCY_SUB_BUCKET_BITS + 1)
+#define LATENCY_COUNTS                  ((LATENCY_BUCKETS + 1) * (LATENCY_SUB_BUCKETS / 2))
+
+
+/* round trips measured by the protocols */
+enum class LatencyMetric : uint8_t
+{
+    AS3_PING,
+    AS3_HISTORY,
+    LV_LIST,
+    INTERCOM_PING,
+    COUNT
+};
+
+
+/*
+ * HDR-style histogram of microsecond values: log2 buckets split into
+ * linear sub-buckets, so the relative error is bounded for any value.
+ * Counts are relaxed atomics written by one thread and read by the reporter.
+ */
+class LatencyHistogram
+{
+private:
+    std::array<std::atomic<uint64_t>, LATENCY_COUNTS> counts{};
+    std::atomic<uint64_t> max_value{0};
+
+public:
+    static size_t index_of(uint64_t _value);
+    static uint64_t value_of(size_t _index);
+
+    /* single writer */
+    void record(uint64_t _value);
+    /* any thread, adds a snapshot of _other */
+    void merge(const LatencyHistogram& _other);
+
+    [[nodiscard]] uint64_t total() const;
+    [[nodiscard]] uint64_t max() const { return max_value.load(std::memory_order_relaxed); }
+    /* highest value equivalent to the _percentile (0..100) */
+    [[nodiscard]] uint64_t percentile(double _percentile) const;
+};
+
+
+/*
+ * Per-thread histograms for every metric, merged for reports. Recording
+ * takes no lock; a thread registers its histograms on first use.
+ */
+class LatencyRecorder
+{
+private:
+    using ThreadHistograms = std::array<LatencyHistogram, static_cast<size_t>(LatencyMetric::COUNT)>;
+
+    std::mutex histograms_mutex;
+    std::vector<std::shared_ptr<ThreadHistograms>> histograms; // kept after the thread exits
+
+private:
+    static LatencyRecorder& instance();
+    static ThreadHistograms& thread_histograms();
+    static const char* metric_name(LatencyMetric _metric);
+
+public:
+    static void record(LatencyMetric _metric, std::chrono::steady_clock::duration _latency);
+
+    /* p50/p90/p99/p99.9/max of every metric with samples, since start */
+    static void report(std::ostream& _stream);
+
+public:
+    LatencyRecorder() = default;
+    LatencyRecorder(const LatencyRecorder&) = delete;
+    LatencyRecorder& operator=(const LatencyRecorder&) = delete;
+};
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+/* compile-time log levels, set with -D LOG_LEVEL=<n> */
+#define LOG_LEVEL_OFF                   (0)
+#define LOG_LEVEL_ERROR                 (1)
+#define LOG_LEVEL_INFO                  (2)
+#define LOG_LEVEL_DEBUG                 (3)
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL                       LOG_LEVEL_INFO
+#endif // LOG_LEVEL
+
+#define LOGGER_RING_CAPACITY            (1024U) // records per thread, power of two
+#define LOGGER_RECORD_PAYLOAD           (96U)   // bytes of hex data kept per record
+#define LOGGER_FLUSH_INTERVAL_MS        (10U)
+
+
+/* not upper case: DEBUG and friends are common macro names (-D DEBUG in Debug builds) */
+enum class LogLevel : uint8_t
+{
+    Error = LOG_LEVEL_ERROR,
+    Info = LOG_LEVEL_INFO,
+    Debug = LOG_LEVEL_DEBUG
+};
+
+
+/*
+ * Asynchronous logger. Every thread writes fixed-size records into its own
+ * single-producer ring (no locks, no allocations), a background thread
+ * drains the rings, formats them and writes each batch with one write(2).
+ * Records are dropped when a ring is full, the drop count is reported.
+ *
+ * Messages must be string literals, they are stored by pointer.
+ * Levels above LOG_LEVEL compile to nothing.
+ */
+class Logger
+{
+private:
+    enum class RecordKind : uint8_t
+    {
+        TEXT,
+        VALUE,
+        HEX
+    };
+
+    struct Record
+    {
+        LogLevel level;
+        RecordKind kind;
+        uint16_t payload_size;
+        const char* message;
+        uint64_t value; // number for VALUE, full data size for HEX
+        std::array<uint8_t, LOGGER_RECORD_PAYLOAD> payload;
+    };
+
+    struct ThreadRing
+    {
+        std::array<Record, LOGGER_RING_CAPACITY> records;
+        alignas(64) std::atomic<size_t> head{0}; // written by the writer thread
+        alignas(64) std::atomic<size_t> tail{0}; // written by the owner thread
+        std::atomic<uint64_t> dropped{0};
+    };
+
+    std::mutex rings_mutex;
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+
+    std::atomic<bool> running{false};
+    std::thread writer;
+
+    /* consumer side only, producers never take it */
+    std::mutex drain_mutex;
+    std::string output;
+
+private:
+    static Logger& instance();
+    static ThreadRing& thread_ring();
+
+    void writer_loop();
+    size_t drain();
+    void format(const Record& record);
+
+    static void push(LogLevel _level, const char* _message, RecordKind _kind, uint64_t _value, const uint8_t* _data, size_t _size);
+
+public:
+    template <LogLevel level>
+    static void log(const char* _message)
+    {
+        if constexpr (static_cast<int>(level) <= LOG_LEVEL)
+        {
+            push(level, _message, RecordKind::TEXT, 0, nullptr, 0);
+        }
+    }
+
+    template <LogLevel level>
+    static void log(const char* _message, const uint64_t _value)
+    {
+        if constexpr (static_cast<int>(level) <= LOG_LEVEL)
+        {
+            push(level, _message, RecordKind::VALUE, _value, nullptr, 0);
+        }
+    }
+
+    /* _text is copied (truncated to the record payload) */
+    template <LogLevel level>
+    static void log(const char* _message, const uint64_t _value, const char* _text)
+    {
+        if constexpr (static_cast<int>(level) <= LOG_LEVEL)
+        {
+            push(level, _message, RecordKind::VALUE, _value, reinterpret_cast<const uint8_t*>(_text), std::strlen(_text));
+        }
+    }
+
+    template <LogLevel level>
+    static void log_hex(const char* _message, const void* _data, const size_t _size)
+    {
+        if constexpr (static_cast<int>(level) <= LOG_LEVEL)
+        {
+            push(level, _message, RecordKind::HEX, _size, static_cast<const uint8_t*>(_data), _size);
+        }
+    }
+
+    static constexpr bool enabled(const LogLevel _level) { return static_cast<int>(_level) <= LOG_LEVEL; }
+
+    /* write everything queued so far */
+    static void flush();
+
+public:
+    Logger();
+    Logger(const Logger&) = delete;
+    Logger& operator=(const Logger&) = delete;
+    ~Logger();
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Capture.hpp"
+
+
+#define METRICS_PROTOCOLS               (8U)   // protocol ids below this get their own frame counters
+#define METRICS_LISTEN_ADDRESS          "127.0.0.1"
+#define METRICS_LISTEN_BACKLOG          (16U)
+
+
+enum class Counter : uint8_t
+{
+    CONNECTIONS_OPENED,
+    CONNECTIONS_CLOSED,
+    HANDSHAKES_OK,
+    HANDSHAKES_FAILED,
+    BYTES_SENT,
+    BYTES_RECEIVED,
+    CRC_FAILURES,
+    TIMEOUTS,
+    RECONNECTS,
+    HISTORY_ACKED,
+    HISTORY_DROPPED,
+    COUNT
+};
+
+
+/*
+ * Process-wide counters in the Prometheus text exposition format, served
+ * by a small HTTP listener on localhost. Every thread adds to its own
+ * counter block with relaxed single-writer stores, a scrape sums the
+ * blocks; only the first use on a thread takes a lock.
+ */
+class Metrics
+{
+private:
+    struct ThreadCounters
+    {
+        std::array<std::atomic<uint64_t>, static_cast<size_t>(Counter::COUNT)> counters{};
+        std::array<std::array<std::atomic<uint64_t>, 2>, METRICS_PROTOCOLS> frames{}; // by CaptureDirection
+    };
+
+    std::mutex counters_mutex;
+    std::vector<std::shared_ptr<ThreadCounters>> counters; // kept after the thread exits
+
+    int listen_fd = -1;
+    std::atomic<bool> running{false};
+    std::thread server;
+
+private:
+    static Metrics& instance();
+    static ThreadCounters& thread_counters();
+    static void increment(std::atomic<uint64_t>& _counter, uint64_t _value);
+
+    void serve_loop();
+    [[nodiscard]] std::string render();
+
+public:
+    static void add(Counter _counter, uint64_t _value = 1);
+    static void add_frame(uint16_t _protocol_id, CaptureDirection _direction, size_t _size);
+    /* sum over all threads, for reports */
+    static uint64_t total(Counter _counter);
+
+    /* start answering scrapes on METRICS_LISTEN_ADDRESS:_port */
+    static void serve(uint16_t _port);
+    static void close();
+
+public:
+    Metrics() = default;
+    Metrics(const Metrics&) = delete;
+    Metrics& operator=(const Metrics&) = delete;
+    ~Metrics();
+};
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "Checksum.hpp"
+
+
+/* big-endian load and store through memcpy, no alignment or aliasing assumptions */
+template <typename T>
+T wire_load(const uint8_t* _data);
+template <typename T>
+void wire_store(uint8_t* _data, T _value);
+
+
+/*
+ * Declarative packet layouts. A packet is a list of field descriptors
+ * bound to members of a plain struct; WirePacket generates the encoder and
+ * the decoder from it. Every descriptor has
+ *
+ *   fixed    - the field has one size
+ *   size     - that size, or an upper bound for variable fields
+ *   put()    - write the field at the cursor, return the cursor after it
+ *   get()    - read the field at the cursor; _end may be narrowed by a length field
+ *   finish() - patch the field once the whole packet is written (length, checksum)
+ *
+ * A fixed packet has its size at compile time and every field offset is a
+ * constant, so the encoder inlines to plain stores at immediate offsets.
+ */
+
+/* member type of a pointer to member */
+template <auto Member>
+struct WireMember;
+
+template <typename Class, typename Type, Type Class::*Member>
+struct WireMember<Member>
+{
+    using type = Type;
+};
+
+
+/* a constant, e.g. a start byte; decoding checks it */
+template <typename T, T Value>
+struct WireConst
+{
+    static constexpr bool fixed = true;
+    static constexpr size_t size = sizeof(T);
+
+    template <typename Object>
+    static uint8_t* put(uint8_t* _cursor, const Object&) { wire_store<T>(_cursor, Value); return _cursor + size; }
+    template <typename Object>
+    static const uint8_t* get(const uint8_t* _cursor, const uint8_t*& _end, Object& _object);
+    static void finish(uint8_t*, uint8_t*, const uint8_t*) {}
+};
+
+/* a member stored as big-endian T: integers, enums, bools, float */
+template <auto Member, typename T>
+struct WireField
+{
+    static constexpr bool fixed = true;
+    static constexpr size_t size = sizeof(T);
+
+    template <typename Object>
+    static uint8_t* put(uint8_t* _cursor, const Object& _object) { wire_store<T>(_cursor, static_cast<T>(_object.*Member)); return _cursor + size; }
+    template <typename Object>
+    static const uint8_t* get(const uint8_t* _cursor, const uint8_t*&, Object& _object)
+    {
+        _object.*Member = static_cast<typename WireMember<Member>::type>(wire_load<T>(_cursor));
+        return _cursor + size;
+    }
+    static void finish(uint8_t*, uint8_t*, const uint8_t*) {}
+};
+
+/* a floating point member stored as an integer count of 1/Scale units */
+template <auto Member, typename T, unsigned Scale>
+struct WireScaled
+{
+    static constexpr bool fixed = true;
+    static constexpr size_t size = sizeof(T);
+
+    template <typename Object>
+    static uint8_t* put(uint8_t* _cursor, const Object& _object);
+    template <typename Object>
+    static const uint8_t* get(const uint8_t* _cursor, const uint8_t*& _end, Object& _object);
+    static void finish(uint8_t*, uint8_t*, const uint8_t*) {}
+};
+
+/* bool members packed into one byte, the first one is bit 0 */
+template <auto... Members>
+struct WireFlags
+{
+    static_assert(sizeof...(Members) > 0 && sizeof...(Members) <= 8, "One to eight flags per byte");
+
+    static constexpr bool fixed = true;
+    static constexpr size_t size = 1;
+
+    template <typename Object>
+    static uint8_t* put(uint8_t* _cursor, const Object& _object);
+    template <typename Object>
+    static const uint8_t* get(const uint8_t* _cursor, const uint8_t*& _end, Object& _object);
+    static void finish(uint8_t*, uint8_t*, const uint8_t*) {}
+};
+
+/* std::string member up to MaxSize bytes and a delimiter; a full-length string has no delimiter */
+template <auto Member, size_t MaxSize, char Delimiter>
+struct WireText
+{
+    static constexpr bool fixed = false;
+    static constexpr size_t size = MaxSize + 1;
+
+    template <typename Object>
+    static uint8_t* put(uint8_t* _cursor, const Object& _object);
+    template <typename Object>
+    static const uint8_t* get(const uint8_t* _cursor, const uint8_t*& _end, Object& _object);
+    static void finish(uint8_t*, uint8_t*, const uint8_t*) {}
+};
+
+/* byte count of the rest of the packet after this field */
+template <typename T>
+struct WireLength
+{
+    static constexpr bool fixed = true;
+    static constexpr size_t size = sizeof(T);
+
+    template <typename Object>
+    static uint8_t* put(uint8_t* _cursor, const Object&) { wire_store<T>(_cursor, 0); return _cursor + size; }
+    template <typename Object>
+    static const uint8_t* get(const uint8_t* _cursor, const uint8_t*& _end, Object& _object);
+    static void finish(uint8_t* _begin, uint8_t* _field, const uint8_t* _end);
+};
+
+/* byte sum of everything before it (Checksum); decoding skips it, the caller checks */
+struct WireChecksum
+{
+    static constexpr bool fixed = true;
+    static constexpr size_t size = sizeof(uint16_t);
+
+    template <typename Object>
+    static uint8_t* put(uint8_t* _cursor, const Object&) { wire_store<uint16_t>(_cursor, 0); return _cursor + size; }
+    template <typename Object>
+    static const uint8_t* get(const uint8_t* _cursor, const uint8_t*&, Object&) { return _cursor + size; }
+    static void finish(uint8_t* _begin, uint8_t* _field, const uint8_t*) { wire_store<uint16_t>(_field, Checksum::compute(_begin, _field - _begin)); }
+};
+
+
+template <typename... Fields>
+class WirePacket;
+
+/* std::vector member as a count of type Count and up to MaxCount elements */
+template <auto Member, typename Count, size_t MaxCount, typename... Fields>
+struct WireRepeated
+{
+    using Element = WirePacket<Fields...>;
+
+    static constexpr bool fixed = false;
+    static constexpr size_t size = sizeof(Count) + MaxCount * Element::size;
+
+    template <typename Object>
+    static uint8_t* put(uint8_t* _cursor, const Object& _object);
+    template <typename Object>
+    static const uint8_t* get(const uint8_t* _cursor, const uint8_t*& _end, Object& _object);
+    static void finish(uint8_t*, uint8_t*, const uint8_t*) {}
+};
+
+
+/*
+ * The packet itself, also usable as a field to share a group of fields
+ * between packets (length and checksum inside a group count from the
+ * group start).
+ */
+template <typename... Fields>
+class WirePacket
+{
+public:
+    static constexpr bool fixed = (Fields::fixed && ...);
+    /* exact for a fixed packet, otherwise the largest packet; sizes buffers */
+    static constexpr size_t size = (Fields::size + ...);
+    static constexpr bool checksummed = std::is_same_v<std::tuple_element_t<sizeof...(Fields) - 1, std::tuple<Fields...>>, WireChecksum>;
+
+    /* offset of the first Field, fixed fields before it */
+    template <typename Field>
+    static constexpr size_t offset_of();
+
+public:
+    /* write _object to _buffer of at least size bytes, returns the packet size */
+    template <typename Object>
+    static size_t encode(uint8_t* _buffer, const Object& _object);
+
+    /* read _object from the front of _packet, returns the bytes used; throws on malformed input */
+    template <typename Object>
+    static size_t decode(std::span<const uint8_t> _packet, Object& _object);
+
+public:
+    /* field interface */
+    template <typename Object>
+    static uint8_t* put(uint8_t* _cursor, const Object& _object) { return _cursor + encode(_cursor, _object); }
+    template <typename Object>
+    static const uint8_t* get(const uint8_t* _cursor, const uint8_t*& _end, Object& _object);
+    static void finish(uint8_t*, uint8_t*, const uint8_t*) {}
+
+private:
+    template <typename Field, typename Object>
+    static const uint8_t* get_field(const uint8_t* _cursor, const uint8_t*& _end, Object& _object);
+};
+
+
+/*
+ * A fixed packet encoded once and then kept current in place: patch()
+ * rewrites one field and moves the trailing checksum by the byte
+ * difference, a few stores instead of a new encode. For periodic packets
+ * where only a timestamp or a counter changes.
+ */
+template <typename Packet>
+class WireTemplate
+{
+    static_assert(Packet::fixed && Packet::checksummed, "Templates are fixed packets ending in a checksum");
+
+private:
+    std::array<uint8_t, Packet::size> bytes{};
+
+public:
+    /* rewrite Field from _object, the checksum follows */
+    template <typename Field, typename Object>
+    void patch(const Object& _object);
+
+    [[nodiscard]] const uint8_t* data() const { return bytes.data(); }
+    [[nodiscard]] static constexpr size_t size() { return Packet::size; }
+
+public:
+    template <typename Object>
+    explicit WireTemplate(const Object& _object) { Packet::encode(bytes.data(), _object); }
+};
+
+#include "PacketSchema.tpp" // include template implementation
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+
+#define RECONNECT_DEFAULT_BASE_MS       (500U)
+#define RECONNECT_DEFAULT_CAP_MS        (60000U)
+#define RECONNECT_STABLE_MS             (30000U) // a connection up this long resets the backoff
+
+
+/*
+ * Exponential backoff with full jitter: the delay before attempt n is
+ * uniform in [0, min(cap, base * 2^n)], which spreads a crowd of clients
+ * that lost their server at the same moment over the whole window.
+ */
+struct ReconnectPolicy
+{
+    bool enabled = false;
+    std::chrono::milliseconds base{RECONNECT_DEFAULT_BASE_MS};
+    std::chrono::milliseconds cap{RECONNECT_DEFAULT_CAP_MS};
+    unsigned max_attempts = 0; // 0 - unlimited
+
+    [[nodiscard]] std::chrono::steady_clock::duration delay(unsigned _attempt) const;
+    [[nodiscard]] bool exhausted(const unsigned _attempt) const { return max_attempts != 0 && _attempt >= max_attempts; }
+    /* attempts start over after a connection that stayed up long enough */
+    [[nodiscard]] static bool stable(std::chrono::steady_clock::duration _uptime) { return _uptime >= std::chrono::milliseconds(RECONNECT_STABLE_MS); }
+};
+
+
+/*
+ * Token bucket in its virtual-time form (GCRA): one atomic holds the
+ * theoretical arrival time of the next token, reserve() advances it by one
+ * interval with a CAS and returns when the token is available. Safe to
+ * share between threads, nobody waits on a lock.
+ */
+class TokenBucket
+{
+private:
+    std::atomic<int64_t> arrival_ns{INT64_MIN}; // steady clock
+    int64_t interval_ns = 0;                    // 0 - unlimited
+    int64_t burst_ns = 0;
+
+public:
+    /* global limiter for connects, unlimited until configured */
+    static TokenBucket& connects();
+
+    /* _rate tokens per second, up to _burst at once; call before threads use the bucket */
+    void configure(double _rate, unsigned _burst);
+
+    /* take a token, not before _earliest; returns when it may be used */
+    std::chrono::steady_clock::time_point reserve(std::chrono::steady_clock::time_point _earliest);
+};
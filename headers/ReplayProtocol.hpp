@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "AbstractProtocol.hpp"
+
+
+struct ReplayFrame
+{
+    uint64_t offset_ns{};   // time since the first frame of the session
+    CaptureDirection direction{};
+    std::vector<uint8_t> data;
+};
+
+struct ReplayTrace
+{
+    ProtocolId protocol = ProtocolId::UNKNOWN;
+    std::vector<ReplayFrame> frames;
+};
+
+
+/*
+ * Replays one recorded session: sent frames go out with their original
+ * spacing divided by _speed (0 - as fast as possible), received frames
+ * are read and compared with the recording.
+ */
+class ReplayProtocol final : public AbstractProtocol
+{
+private:
+    ReplayTrace trace;
+    double speed;
+
+public:
+    /* binary capture (one session, the first one by default) or a hex dump log */
+    static ReplayTrace load(const std::string& _path, uint32_t _session_id = UINT32_MAX);
+    static ReplayTrace load_capture(const std::string& _path, uint32_t _session_id);
+    static ReplayTrace load_hex_dump(const std::string& _path);
+
+public:
+    ReplayProtocol(ReplayTrace _trace, double _speed);
+    ~ReplayProtocol() override = default;
+
+public:
+    void handler_loop(int _socket_fd) override;
+    [[nodiscard]] ProtocolId protocol_id() const override { return trace.protocol; }
+};
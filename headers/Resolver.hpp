@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+
+
+#define RESOLVER_TTL_S                  (60U) // getaddrinfo has no ttl, answers are kept this long
+#define RESOLVER_FAILURE_TTL_S          (5U)  // failed lookups are retried after this
+
+
+/* one resolved endpoint, any address family */
+struct SocketAddress
+{
+    sockaddr_storage storage{};
+    socklen_t length = 0;
+
+    [[nodiscard]] const sockaddr* data() const { return reinterpret_cast<const sockaddr*>(&storage); }
+    [[nodiscard]] int family() const { return storage.ss_family; }
+    [[nodiscard]] uint16_t port() const;
+    void set_port(uint16_t _port);
+    /* "1.2.3.4:80" or "[::1]:80" */
+    [[nodiscard]] std::string to_string() const;
+};
+
+using AddressList = std::vector<SocketAddress>;
+
+
+/*
+ * Name resolution off the connecting threads. getaddrinfo runs on its own
+ * thread and every caller of the same host and port shares that lookup
+ * through a future, so a fleet resolves its target once. Answers are
+ * cached for RESOLVER_TTL_S and come back with the address families
+ * interleaved for Happy Eyeballs (RFC 8305). IPv6 literals may be given
+ * in brackets ("[::1]").
+ */
+class Resolver
+{
+private:
+    struct Entry
+    {
+        std::shared_future<AddressList> addresses;
+        std::chrono::steady_clock::time_point started;
+    };
+
+    std::mutex cache_mutex;
+    std::unordered_map<std::string, Entry> cache;
+    std::atomic<int> family{AF_UNSPEC};
+
+private:
+    static Resolver& instance();
+    static AddressList lookup(const std::string& _host, uint16_t _port, int _family);
+
+public:
+    /* AF_INET or AF_INET6 restricts answers to one family, AF_UNSPEC (default) is dual stack */
+    static void set_family(int _family);
+    /* numeric address without a lookup, IPv6 may be in brackets */
+    static SocketAddress parse_numeric(const std::string& _address, uint16_t _port);
+
+    /* cached answer or a lookup in flight, never blocks */
+    static std::shared_future<AddressList> resolve_async(const std::string& _host, uint16_t _port);
+    /* waits for resolve_async(), throws on failure */
+    static AddressList resolve(const std::string& _host, uint16_t _port);
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <span>
+#include <sys/types.h>
+
+
+#define RING_BUFFER_DEFAULT_CAPACITY        (4096U)
+#define RING_BUFFER_MAX_CAPACITY            (1U << 20)  // largest frame a protocol may wait for
+
+
+/*
+ * Byte ring used as per-connection receive buffer. The storage is mapped
+ * twice back to back (memfd + two MAP_FIXED views), so every readable or
+ * writable region is contiguous, even when it wraps the end of the ring.
+ * fill() reads as much as the socket holds with one recv call, up to the
+ * free space; the ring only grows by reserve(), never by what a peer sends.
+ *
+ * Every ring costs two mappings, raise vm.max_map_count for very large fleets.
+ */
+class RingBuffer
+{
+private:
+    uint8_t* base = nullptr;
+    size_t ring_capacity = 0;
+    size_t head = 0; // read position, grows monotonically
+    size_t tail = 0; // write position, grows monotonically
+
+    [[nodiscard]] size_t mask() const { return ring_capacity - 1; }
+
+    static uint8_t* map(size_t _capacity);
+    static void unmap(uint8_t* _base, size_t _capacity);
+
+public:
+    [[nodiscard]] size_t size() const { return tail - head; }
+    [[nodiscard]] size_t capacity() const { return ring_capacity; }
+    [[nodiscard]] size_t free_space() const { return capacity() - size(); }
+    [[nodiscard]] bool empty() const { return head == tail; }
+    [[nodiscard]] uint8_t front() const { return base[head & mask()]; }
+
+    void clear();
+    void reserve(size_t _size);
+    void append(const uint8_t* data, size_t _size);
+    void consume(size_t _size);
+    void copy_out(uint8_t* data, size_t _size) const;
+    [[nodiscard]] std::span<const uint8_t> peek(size_t _size) const;
+
+    /* recv into the free space, which must not be empty */
+    ssize_t fill(int socket_fd, int flags);
+
+public:
+    RingBuffer() = default;
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+    ~RingBuffer();
+};
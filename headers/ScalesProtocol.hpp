@@ -4,10 +4,19 @@
 
 class ScalesProtocol : public AbstractProtocol
 {
+protected:
+    void on_data() override;
+    void on_timer() override;
+
 public:
     ScalesProtocol() = default;
     ~ScalesProtocol() override = default;
 
 public:
     void handler_loop(int _socket_fd) override;
-};
\ No newline at end of file
+    [[nodiscard]] ProtocolId protocol_id() const override { return ProtocolId::SCALES; }
+
+public:
+    [[nodiscard]] bool supports_events() const override { return true; }
+    void on_connected(int _socket_fd) override;
+};
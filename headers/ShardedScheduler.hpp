@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ConnectionManager.hpp"
+#include "SpscQueue.hpp"
+
+
+#define SCHEDULER_QUEUE_CAPACITY            (4096U)
+#define SCHEDULER_STATS_INTERVAL_MS         (100U)
+
+
+/*
+ * Runs sessions on N worker threads, each pinned to a core and owning its
+ * own ConnectionManager (event loop, timers, buffers). New sessions are
+ * handed over through one SPSC queue per worker, so workers share no locks.
+ * submit() must always be called from the same thread.
+ */
+class ShardedScheduler
+{
+public:
+    struct Stats
+    {
+        size_t connects = 0;
+        size_t connect_failures = 0;
+        size_t closes = 0;
+        size_t reconnects = 0;
+        size_t active = 0;
+    };
+
+private:
+    struct Shard
+    {
+        size_t index = 0;
+        std::unique_ptr<ConnectionManager> manager;
+        SpscQueue<std::shared_ptr<AbstractProtocol>> queue{SCHEDULER_QUEUE_CAPACITY};
+        std::thread thread;
+
+        /* published by the worker, read by stats() */
+        std::atomic<size_t> connects{0};
+        std::atomic<size_t> connect_failures{0};
+        std::atomic<size_t> closes{0};
+        std::atomic<size_t> reconnects{0};
+        std::atomic<size_t> active{0};
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    size_t next_shard = 0;
+    std::atomic<bool> stopping{false};
+
+private:
+    static void pin_thread(std::thread& _thread, size_t _core);
+    void drain_queue(Shard& _shard) const;
+
+public:
+    /* round robin over the shards, waits while the chosen queue is full */
+    void submit(std::shared_ptr<AbstractProtocol> _protocol);
+    /* before start() */
+    void set_reconnect(const ReconnectPolicy& _reconnect);
+    void set_socket_options(const SocketOptions& _socket_options);
+
+    void start();
+    void stop();
+
+    [[nodiscard]] Stats stats() const;
+    [[nodiscard]] size_t workers() const { return shards.size(); }
+
+public:
+    /* _capacity: sessions per worker (sizes io_uring buffers) */
+    ShardedScheduler(const std::string& _host, uint16_t _port, size_t _workers, size_t _capacity);
+    ShardedScheduler(const ShardedScheduler&) = delete;
+    ShardedScheduler& operator=(const ShardedScheduler&) = delete;
+    ~ShardedScheduler();
+};
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <optional>
+#include <string>
+
+
+/*
+ * Socket tuning profile. Every option is optional, an unset one keeps the
+ * kernel default; a protocol declares its profile and the command line
+ * can override single options on top of it. Applied between socket() and
+ * connect(), so the buffer sizes still count for window scaling.
+ */
+struct SocketOptions
+{
+    std::optional<bool> no_delay;           // TCP_NODELAY, small frames go out without waiting for an ack
+    std::optional<bool> quick_ack;          // TCP_QUICKACK, the kernel may drop back to delayed acks later
+    std::optional<int> send_buffer;         // SO_SNDBUF bytes, fixes the size and disables autotuning
+    std::optional<int> receive_buffer;      // SO_RCVBUF bytes
+    std::optional<int> keepalive_idle_s;    // SO_KEEPALIVE with TCP_KEEPIDLE/KEEPINTVL/KEEPCNT, 0 - off
+    std::optional<int> keepalive_interval_s;
+    std::optional<int> keepalive_count;
+    std::optional<int> busy_poll_us;        // SO_BUSY_POLL, above net.core.busy_poll needs CAP_NET_ADMIN
+    std::optional<unsigned> user_timeout_ms; // TCP_USER_TIMEOUT, unacked data drops the connection after this
+
+    /* options set in _overrides replace ours */
+    [[nodiscard]] SocketOptions merged(const SocketOptions& _overrides) const;
+
+    void apply(int _socket_fd) const;
+
+    /* "nodelay,quickack=0,sndbuf=65536,rcvbuf=65536,keepalive=60:10:3,busypoll=50,usertimeout=20000" */
+    static SocketOptions parse(const std::string& _text);
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+
+#include "Resolver.hpp"
+
+
+/*
+ * Local end of outgoing connections, a pool of source addresses each with
+ * an optional explicit port range ("10.0.0.2", "10.0.0.2:20000-29999",
+ * "[fd00::2]:20000-29999"). Sockets take the sources round robin, which
+ * multiplies the connections one host can hold against a single server
+ * port: every source address brings its own set of 4-tuples.
+ *
+ * Sources without a range bind with IP_BIND_ADDRESS_NO_PORT, the kernel
+ * picks the port at connect() and only needs it unique per destination.
+ * Ranges hand out ports from a rotating cursor with SO_REUSEADDR, so the
+ * same port can serve several destinations. bind() then accepts a port
+ * that already has a connection or a TIME_WAIT to this destination too,
+ * only connect() sees the 4-tuple and fails with EADDRNOTAVAIL: callers
+ * retry on a new socket, which takes the next port (see port_busy).
+ * Sockets of a family no source has are left to the kernel.
+ */
+class SourceBinding
+{
+private:
+    struct Source
+    {
+        SocketAddress address;
+        uint16_t first_port = 0;            // 0 - the kernel picks the port
+        uint16_t last_port = 0;
+        std::atomic<uint32_t> next_port{0};
+    };
+
+    std::deque<Source> sources;             // deque, a source never moves
+    std::atomic<uint32_t> next_source{0};
+
+private:
+    static SourceBinding& instance();
+
+    /* false when the range of _source is exhausted */
+    static bool bind_source(Source& _source, int _socket_fd);
+
+public:
+    /* add sources, comma separated; call before threads connect */
+    static void add(const std::string& _sources);
+
+    /*
+     * bind _socket_fd to the next source before connect(), no-op without a source of _family;
+     * true when the port came from a range
+     */
+    static bool bind(int _socket_fd, int _family);
+
+    /* ports of all ranges of _family, the most connect() retries that can help */
+    static size_t range_ports(int _family);
+
+    /* connect() failed with _error on a socket bound to a range port that already reaches the destination */
+    static bool port_busy(bool _range_port, int _error) { return _range_port && _error == EADDRNOTAVAIL; }
+};
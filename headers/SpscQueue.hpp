@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+
+/*
+ * Bounded lock-free queue for exactly one producer and one consumer thread.
+ * Capacity is rounded up to a power of two; head and tail live on separate
+ * cache lines, each side caches the other's index to avoid extra loads.
+ */
+template <typename T>
+class SpscQueue
+{
+private:
+    std::unique_ptr<T[]> slots;
+    size_t mask;
+
+    alignas(64) std::atomic<size_t> head{0}; // consumer position
+    size_t cached_tail = 0;                  // consumer copy of tail
+
+    alignas(64) std::atomic<size_t> tail{0}; // producer position
+    size_t cached_head = 0;                  // producer copy of head
+
+public:
+    /* producer side, false when full */
+    bool try_push(T&& _value);
+    /* consumer side, false when empty */
+    bool try_pop(T& _value);
+
+    [[nodiscard]] bool empty() const { return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire); }
+    [[nodiscard]] size_t capacity() const { return mask + 1; }
+
+public:
+    explicit SpscQueue(size_t _capacity);
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+};
+
+#include "SpscQueue.tpp" // include template implementation
@@ -6,10 +6,16 @@
 #include <netinet/in.h>
 
 #include "AbstractProtocol.hpp"
+#include "Reconnect.hpp"
+#include "Resolver.hpp"
+#include "SourceBinding.hpp"
+#include "SocketOptions.hpp"
 
 
 #define CLIENT_SOCKET_SEND_TIMEOUT          30U
 #define CLIENT_SOCKET_RCV_TIMEOUT           30U
+#define CLIENT_CONNECT_TIMEOUT_MS           10000U  // per connect, all addresses together
+#define CLIENT_CONNECTION_ATTEMPT_DELAY_MS  250U    // Happy Eyeballs head start of an address (RFC 8305)
 
 
 class TCP_Client
@@ -17,18 +23,38 @@ class TCP_Client
 private:
     std::shared_ptr<AbstractProtocol> protocol;
 
-    in_addr_t ip;
+    std::string host;
     uint16_t port;
-    int client_socket = 0;
+    SocketAddress server_address;
+    int client_socket = -1;
+    ReconnectPolicy reconnect;
+    SocketOptions socket_options; // on top of the protocol profile
 
 private:
-    void create_socket();
+    /* _range_port: bound to a source port range, see SourceBinding::port_busy */
+    [[nodiscard]] int create_socket(int _family, bool& _range_port) const;
+    /* socket with connect() started, a busy source port moves on to the next one */
+    [[nodiscard]] int open_socket(const SocketAddress& _address) const;
+    /* Happy Eyeballs: a new address every attempt delay, the first connected one wins */
+    void connect_to(const AddressList& _addresses);
+    void close_socket();
+    void run_connection();
+    void run_protocol();
+#ifdef NON_BLOCKING
+    void event_loop();
+#endif // NON_BLOCKING
 
 public:
+    /* reconnect after errors or a finished handler, see ReconnectPolicy */
+    void set_reconnect(const ReconnectPolicy& _reconnect) { reconnect = _reconnect; }
+    /* options set here replace those of the protocol profile */
+    void set_socket_options(const SocketOptions& _socket_options) { socket_options = _socket_options; }
+
     void run();
-    void stop() const;
+    void stop();
 
 public:
-    TCP_Client(const std::string& _ip, uint16_t _port, std::shared_ptr<AbstractProtocol> _protocol);
+    /* _host: name or address literal */
+    TCP_Client(std::string _host, uint16_t _port, std::shared_ptr<AbstractProtocol> _protocol);
     ~TCP_Client();
 };
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <utility>
+
+
+/*
+ * Lazily started coroutine. Awaiting a Task runs it and resumes the awaiting
+ * coroutine when it finishes, exceptions are rethrown to the awaiter.
+ */
+class Task
+{
+public:
+    struct promise_type
+    {
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+        std::exception_ptr exception;
+
+        struct FinalAwaiter
+        {
+            [[nodiscard]] bool await_ready() const noexcept { return false; }
+            [[nodiscard]] std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> _handle) const noexcept
+            {
+                return _handle.promise().continuation;
+            }
+            void await_resume() const noexcept {}
+        };
+
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+        FinalAwaiter final_suspend() const noexcept { return {}; }
+        void return_void() const noexcept {}
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+    };
+
+private:
+    std::coroutine_handle<promise_type> handle;
+
+    explicit Task(std::coroutine_handle<promise_type> _handle) : handle(_handle) {}
+
+public:
+    [[nodiscard]] bool await_ready() const noexcept { return !handle || handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> _caller) const noexcept
+    {
+        handle.promise().continuation = _caller;
+        return handle;
+    }
+    void await_resume() const { rethrow_if_failed(); }
+
+public:
+    void start() const
+    {
+        if (handle && !handle.done())
+        {
+            handle.resume();
+        }
+    }
+
+    [[nodiscard]] bool done() const { return !handle || handle.done(); }
+
+    void rethrow_if_failed() const
+    {
+        if (handle && handle.promise().exception)
+        {
+            std::rethrow_exception(handle.promise().exception);
+        }
+    }
+
+public:
+    Task() = default;
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    Task(Task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    Task& operator=(Task&& other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle)
+            {
+                handle.destroy();
+            }
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+    ~Task()
+    {
+        if (handle)
+        {
+            handle.destroy();
+        }
+    }
+};
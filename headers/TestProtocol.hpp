@@ -10,4 +10,5 @@ public:
 
 public:
     void handler_loop(int _socket_fd) override;
+    [[nodiscard]] ProtocolId protocol_id() const override { return ProtocolId::TEST; }
 };
\ No newline at end of file
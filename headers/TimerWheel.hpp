@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+
+#define TIMER_WHEEL_LEVELS              (4U)
+#define TIMER_WHEEL_SLOT_BITS           (8U)
+#define TIMER_WHEEL_SLOTS               (1U << TIMER_WHEEL_SLOT_BITS)
+
+
+/*
+ * Intrusive timer node, embedded in the object that owns the timer.
+ * The owner must not move while the node is scheduled.
+ */
+struct TimerNode
+{
+    TimerNode* next = nullptr;
+    TimerNode* prev = nullptr;
+    uint64_t expires = 0; // tick
+    size_t owner = 0;     // id of the owning object
+
+    [[nodiscard]] bool scheduled() const { return next != nullptr; }
+};
+
+
+/*
+ * Hierarchical timer wheel: 4 levels of 256 slots, level n slots span
+ * 256^n ticks (with 1 ms ticks about 49 days in total). Scheduling and
+ * cancelling are O(1) list operations; timers of upper levels cascade
+ * down when the lower level wraps. Nodes are never allocated by the wheel.
+ */
+class TimerWheel
+{
+private:
+    std::array<std::array<TimerNode, TIMER_WHEEL_SLOTS>, TIMER_WHEEL_LEVELS> slots;
+    uint64_t current = 0; // last processed tick
+    size_t count = 0;
+
+private:
+    static void link(TimerNode& head, TimerNode& node);
+    static void unlink(TimerNode& node);
+
+    void place(TimerNode& node);
+    void cascade(unsigned level);
+
+public:
+    /* (re)schedule the node at an absolute tick, past ticks expire on the next advance */
+    void schedule(TimerNode& node, uint64_t expires);
+    void cancel(TimerNode& node);
+
+    /* expire every node up to _now, the callback may reschedule the node */
+    template <typename Callback>
+    void advance(uint64_t _now, Callback&& _callback);
+
+    /* ticks until the next possible expiry (a lower bound for timers above level 0), UINT64_MAX when empty */
+    [[nodiscard]] uint64_t next_expiry() const;
+
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] uint64_t now() const { return current; }
+
+public:
+    TimerWheel();
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+};
+
+#include "TimerWheel.tpp" // include template implementation
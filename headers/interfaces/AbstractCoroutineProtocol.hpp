@@ -0,0 +1,88 @@
+#pragma once
+
+#include <coroutine>
+
+#include "AbstractProtocol.hpp"
+#include "Task.hpp"
+
+
+/*
+ * Event-driven protocol written as one sequential coroutine. Awaitables are
+ * resumed by the event loop (ConnectionManager or TCP_Client) instead of
+ * blocking the thread. Received bytes stay buffered until an async_recv
+ * asks for them, so replies may arrive while the session waits on a send
+ * or a timer (pipelined requests).
+ */
+class AbstractCoroutineProtocol : public AbstractProtocol
+{
+private:
+    enum class WaitReason
+    {
+        NONE,
+        RECV,
+        SEND,
+        SLEEP
+    };
+
+    Task task;
+    std::coroutine_handle<> waiting;
+    WaitReason wait_reason = WaitReason::NONE;
+
+    void suspend(std::coroutine_handle<> _handle, WaitReason reason);
+    void resume(WaitReason reason);
+    /* move a buffered message to data */
+    void receive(uint8_t* data, size_t size);
+
+protected:
+    struct RecvAwaitable
+    {
+        AbstractCoroutineProtocol& protocol;
+        uint8_t* data;
+        size_t size;
+
+        /* already buffered, no suspension */
+        [[nodiscard]] bool await_ready() const noexcept { return protocol.rx_buffer.size() >= size; }
+        void await_suspend(std::coroutine_handle<> _handle) const;
+        void await_resume() const { protocol.receive(data, size); }
+    };
+
+    struct SendAwaitable
+    {
+        AbstractCoroutineProtocol& protocol;
+        const void* data;
+        size_t size;
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> _handle) const;
+        void await_resume() const noexcept {}
+    };
+
+    struct SleepAwaitable
+    {
+        AbstractCoroutineProtocol& protocol;
+        clock::duration delay;
+
+        [[nodiscard]] bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> _handle) const;
+        void await_resume() const noexcept {}
+    };
+
+    RecvAwaitable async_recv(void* data, size_t size);
+    SendAwaitable async_send(const void* data, size_t size);
+    SleepAwaitable sleep_for(clock::duration delay);
+
+    virtual Task session() = 0;
+
+protected:
+    void on_data() override;
+    void on_timer() override;
+    void on_drained() override;
+
+public:
+    AbstractCoroutineProtocol() = default;
+    ~AbstractCoroutineProtocol() override = default;
+
+public:
+    [[nodiscard]] bool supports_events() const override { return true; }
+    void on_connected(int _socket_fd) override;
+};
@@ -1,6 +1,19 @@
 #pragma once
 
 #include <iostream>
+#include <array>
+#include <vector>
+#include <chrono>
+#include <span>
+#include <initializer_list>
+#include <sys/uio.h>
+
+#include "RingBuffer.hpp"
+#include "Logger.hpp"
+#include "Capture.hpp"
+#include "LatencyRecorder.hpp"
+#include "Metrics.hpp"
+#include "SocketOptions.hpp"
 
 #if defined(__APPLE__)
 #include <libkern/OSByteOrder.h>
@@ -14,18 +27,71 @@
 #include <arpa/inet.h>
 #endif
 
+/* protocol ids written to captures */
+enum class ProtocolId : uint16_t
+{
+    UNKNOWN = 0,
+    TEST,
+    INTERCOM,
+    SCALES,
+    AS3,
+    LV,
+    BA5
+};
+
 class AbstractProtocol
 {
+public:
+    using clock = std::chrono::steady_clock;
+
 protected:
     int socket_fd = 0;
+    uint32_t session_id = 0;
+
+    /* per-connection receive buffer, filled with as much as the socket holds */
+    RingBuffer rx_buffer;
+
+    /* small sends waiting to go out with the next send_data in one segment */
+    std::vector<uint8_t> tx_deferred;
 
     template <typename T>
     static void log_buffer_hex(T buffer, size_t size);
+    void record_frame(CaptureDirection direction, const iovec* parts, size_t count) const;
+    /* hex log and capture of a message handed to the protocol */
+    void record_received(const uint8_t* data, size_t size) const;
 
     template <typename T>
     ssize_t recv_data(T data, size_t size);
     template <typename T>
     ssize_t send_data(T data, size_t size);
+    ssize_t send_data(std::initializer_list<iovec> parts);
+    void defer_send(const void* data, size_t size);
+
+    std::span<const uint8_t> recv_view(size_t size);
+
+    void wait_socket(short events, int timeout_ms) const;
+
+protected:
+    /* event-driven mode state (used only when driven by ConnectionManager) */
+    size_t rx_expected = 0;
+    std::vector<uint8_t> tx_buffer;
+    size_t tx_offset = 0;
+    clock::time_point timer_deadline{};
+    bool closing = false;
+    bool deferred_io = false;
+
+    void expect(size_t size);
+    void queue_data(const void* data, size_t size);
+    void consume(size_t size);
+    void set_timer(clock::duration delay);
+    /* period spread by +-percent, keeps a fleet from firing in lockstep */
+    static clock::duration jittered(clock::duration period, unsigned percent);
+    void close_session();
+
+    virtual void on_data();
+    virtual void on_message(const uint8_t* data, size_t size);
+    virtual void on_timer() {}
+    virtual void on_drained() {}
 
 public:
     AbstractProtocol() = default;
@@ -33,6 +99,33 @@ public:
 
 public:
     virtual void handler_loop(int _socket_fd) = 0;
+    /* bind a new connection, drops everything buffered for the previous one */
+    void attach(int _socket_fd);
+
+    [[nodiscard]] virtual ProtocolId protocol_id() const { return ProtocolId::UNKNOWN; }
+    /* socket tuning this protocol wants, kernel defaults unless overridden */
+    [[nodiscard]] virtual SocketOptions socket_options() const { return {}; }
+    void set_session_id(const uint32_t _session_id) { session_id = _session_id; }
+
+public:
+    /* event-driven interface */
+    [[nodiscard]] virtual bool supports_events() const { return false; }
+
+    virtual void on_connected(int _socket_fd);
+    void on_readable();
+    void on_writable();
+    void on_timer_expired();
+
+    /* completion-based I/O, the event loop does recv/send itself */
+    void set_deferred_io(const bool _deferred_io) { deferred_io = _deferred_io; }
+    void on_received(const uint8_t* data, size_t size);
+    void on_sent(size_t size);
+    [[nodiscard]] const uint8_t* pending_data() const { return tx_buffer.data() + tx_offset; }
+    [[nodiscard]] size_t pending_size() const { return tx_buffer.size() - tx_offset; }
+
+    [[nodiscard]] bool wants_write() const { return tx_offset < tx_buffer.size(); }
+    [[nodiscard]] bool is_closing() const { return closing; }
+    [[nodiscard]] clock::time_point next_timer() const { return timer_deadline; }
 };
 
 #include "AbstractProtocol.tpp" // include template implementation
@@ -1,24 +1,213 @@
 #include <iostream>
+#include <cmath>
+#include <unistd.h>
 
 #include "TCP_Client.hpp"
+#include "ConnectionManager.hpp"
+#include "Fleet.hpp"
 #include "TestProtocol.hpp"
 #include "IntercomAppProtocol.hpp"
 #include "ScalesProtocol.hpp"
 #include "AS3_Protocol.hpp"
 #include "LV_Protocol.hpp"
 #include "BA5_Protocol.hpp"
+#include "ReplayProtocol.hpp"
+#include "Capture.hpp"
+#include "LatencyRecorder.hpp"
+#include "Metrics.hpp"
 
 //#define SERVER_DOMAIN       "192.168.0.92"
 #define SERVER_DOMAIN       "91.103.28.124"
 // #define SERVER_DOMAIN       "127.0.0.1"
 #define SERVER_PORT         5681
 
-int main()
+int main(int argc, char* argv[])
 {
+    std::string replay_file;
+    double replay_speed = 1.0;
+    FleetConfig fleet;
+    ReconnectPolicy reconnect;
+    SocketOptions socket_options;
+    std::string journal_file;
+    size_t journal_capacity = HISTORY_JOURNAL_DEFAULT_CAPACITY;
+
+    // parse options: [-c capture_file] [-s metrics_port] [-a base_ms[:cap_ms]] [-l connects_per_second[:burst]]
+    //                [-4 | -6] [-b source_address[:first_port[-last_port]][,...]]... [-o socket_options]
+    //                [-r replay_file [-x speed]]
+    //                [-i first_imei] [-m mix] [-p linear|step|spike] [-d ramp_seconds] [-k steps] [-w workers]
+    //                [-e history_events[:window]] [-j journal_file[:records]] [devices]
+    int option;
+    while ((option = getopt(argc, argv, "c:s:a:l:46b:o:r:x:i:m:p:d:k:w:e:j:")) != -1)
+    {
+        switch (option)
+        {
+            case 'c':
+                // record every frame to a binary capture
+                Capture::open(optarg);
+                break;
+
+            case 's':
+                // serve prometheus metrics on localhost
+                Metrics::serve(static_cast<uint16_t>(std::stoul(optarg)));
+                break;
+
+            case 'a':
+            {
+                // reconnect with exponential backoff
+                const std::string value = optarg;
+                const size_t separator = value.find(':');
+                reconnect.enabled = true;
+                reconnect.base = std::chrono::milliseconds(std::stoul(value.substr(0, separator)));
+                if (separator != std::string::npos)
+                {
+                    reconnect.cap = std::chrono::milliseconds(std::stoul(value.substr(separator + 1)));
+                }
+                break;
+            }
+
+            case 'l':
+            {
+                // global connect rate, a second's worth of burst by default
+                const std::string value = optarg;
+                const size_t separator = value.find(':');
+                const double rate = std::stod(value.substr(0, separator));
+                const auto burst = separator == std::string::npos ? static_cast<unsigned>(std::ceil(rate)) : static_cast<unsigned>(std::stoul(value.substr(separator + 1)));
+                TokenBucket::connects().configure(rate, burst);
+                break;
+            }
+
+            case '4':
+                // one address family only, dual stack by default
+                Resolver::set_family(AF_INET);
+                break;
+
+            case '6':
+                Resolver::set_family(AF_INET6);
+                break;
+
+            case 'b':
+                // pool of local addresses and port ranges, used round robin
+                SourceBinding::add(optarg);
+                break;
+
+            case 'o':
+                // override the protocol socket profile, e.g. nodelay=0,sndbuf=65536
+                socket_options = SocketOptions::parse(optarg);
+                break;
+
+            case 'r':
+                replay_file = optarg;
+                break;
+
+            case 'x':
+                // time scale, 0 - as fast as possible
+                replay_speed = std::stod(optarg);
+                break;
+
+            case 'i':
+                fleet.first_imei = std::stoull(optarg);
+                break;
+
+            case 'm':
+                // protocol weights, e.g. as3:3,intercom:1
+                fleet.mix = Fleet::parse_mix(optarg);
+                break;
+
+            case 'p':
+                fleet.ramp = Fleet::parse_ramp(optarg);
+                break;
+
+            case 'd':
+                fleet.ramp_time = std::chrono::milliseconds(static_cast<int64_t>(std::stod(optarg) * 1000));
+                break;
+
+            case 'k':
+                fleet.ramp_steps = static_cast<unsigned>(std::stoul(optarg));
+                break;
+
+            case 'w':
+                // worker threads, one event loop per core
+                fleet.workers = std::stoul(optarg);
+                break;
+
+            case 'e':
+            {
+                // history each AS3 device flushes on connect, pipelined window deep
+                const std::string value = optarg;
+                const size_t separator = value.find(':');
+                fleet.history.backlog = std::stoul(value.substr(0, separator));
+                if (separator != std::string::npos)
+                {
+                    fleet.history.window = std::stoul(value.substr(separator + 1));
+                }
+                break;
+            }
+
+            case 'j':
+            {
+                // keep the history backlogs in a file, resumed by the next run
+                const std::string value = optarg;
+                const size_t separator = value.rfind(':');
+                journal_file = value.substr(0, separator);
+                if (separator != std::string::npos)
+                {
+                    journal_capacity = std::stoul(value.substr(separator + 1));
+                }
+                break;
+            }
+
+            default:
+                std::cerr << "Usage: " << argv[0] << " [-c capture_file] [-s metrics_port] [-a base_ms[:cap_ms]] [-l connects_per_second[:burst]]"
+                          << " [-4 | -6] [-b source_address[:first_port[-last_port]][,...]]... [-o socket_options] [-r replay_file [-x speed]]"
+                          << " [-i first_imei] [-m mix] [-p linear|step|spike] [-d ramp_seconds] [-k steps] [-w workers]"
+                          << " [-e history_events[:window]] [-j journal_file[:records]] [devices]" << std::endl;
+                return 1;
+        }
+    }
+
+    // replay a recorded session
+    if (!replay_file.empty())
+    {
+        const auto protocol = std::make_shared<ReplayProtocol>(ReplayProtocol::load(replay_file), replay_speed);
+
+        TCP_Client client(SERVER_DOMAIN, SERVER_PORT, protocol);
+        client.set_socket_options(socket_options);
+        client.run();
+
+        Capture::close();
+        Metrics::close();
+        return 0;
+    }
+
+    // run a fleet of simulated devices
+    if (optind < argc)
+    {
+        fleet.devices = std::stoul(argv[optind]);
+        fleet.reconnect = reconnect;
+        fleet.socket_options = socket_options;
+        if (!journal_file.empty())
+        {
+            fleet.history.journal = std::make_shared<HistoryJournal>(journal_file, fleet.devices, journal_capacity, AS3_Protocol::history_record_size());
+        }
+
+        Fleet generator(SERVER_DOMAIN, SERVER_PORT, fleet);
+        generator.run();
+        LatencyRecorder::report(std::cout);
+
+        Capture::close();
+        Metrics::close();
+        return 0;
+    }
+
     // create a protocol
     const auto protocol = std::make_shared<LV_Protocol>();
 
     TCP_Client client(SERVER_DOMAIN, SERVER_PORT, protocol);
+    client.set_reconnect(reconnect);
+    client.set_socket_options(socket_options);
     client.run();
+    LatencyRecorder::report(std::cout);
 
+    Capture::close();
+    Metrics::close();
 }
\ No newline at end of file
@@ -1,8 +1,10 @@
-#include <numeric>
 #include <atomic>
+#include <deque>
 #include <vector>
+#include <span>
 #include <unistd.h>
 #include "AS3_Protocol.hpp"
+#include "PacketSchema.hpp"
 
 #define OK_DATA                                     (0x01U)
 #define ERROR_DATA                                  (0x00U)
@@ -26,6 +28,14 @@
 #define HISTORY_PACKET_SIZE                         (11U)
 #define TIME_SYNC_PACKET_SIZE                       (5U)
 
+#define DEVICE_IMEI                                 (862686042898620ULL)
+#define DEVICE_FIRMWARE_MAJOR                       (1U)
+#define DEVICE_FIRMWARE_MINOR                       (2U)
+#define DEVICE_FIRMWARE_PATCH                       (10U)
+#define PING_INTERVAL                               (30U)
+#define PING_JITTER_PERCENT                         (10U)
+#define HISTORY_EVENT_SPACING_S                     (60U) // backlog events are this far apart, the last one now
+
 #define STRING_DELIMITER                            ('\t')
 #define LISTENER_ADDRESS_MAX_SIZE                   (63U)
 #define SIM_APN_MAX_SIZE                            (31U)
@@ -140,295 +150,176 @@ struct DeviceObject
     command_src_t active_command_src;
 }; // struct DeviceObject
 
-void get_string_from_buffer(const uint8_t *buff, std::uintptr_t &bufiter, std::string &str,
-                            const char delimiter, const std::uint8_t str_max_size)
+// packet layouts, see PacketSchema.hpp
+using HandshakeSchema = WirePacket<
+    WireConst<std::uint16_t, HANDSHAKE_STARTBYTE>,
+    WireField<&DeviceObject::imei, std::uint64_t>,
+    WireField<&DeviceObject::firmware_major, std::uint8_t>,
+    WireField<&DeviceObject::firmware_minor, std::uint8_t>,
+    WireField<&DeviceObject::firmware_patch, std::uint8_t>,
+    WireChecksum>;
+
+// the only ping field that changes between pings
+using PingTime = WireField<&DeviceObject::device_time, std::uint32_t>;
+
+using PingSchema = WirePacket<
+    WireConst<std::uint8_t, PING_STARTBYTE>,
+    PingTime,
+    WireField<&DeviceObject::connection_type, std::uint8_t>,
+    WireField<&DeviceObject::phase_status, std::uint8_t>,
+    WireScaled<&DeviceObject::battery_voltage, std::uint16_t, 1000>,   // mV
+    WireFlags<&DeviceObject::sim1_present, &DeviceObject::sim2_present, &DeviceObject::active_sim>,
+    WireField<&DeviceObject::sim1_signal_quality, std::uint8_t>,
+    WireField<&DeviceObject::sim2_signal_quality, std::uint8_t>,
+    WireField<&DeviceObject::active_command, std::uint8_t>,
+    WireField<&DeviceObject::active_command_src, std::uint8_t>,
+    WireChecksum>;
+
+template <std::uint8_t StartByte>
+using CommandSchema = WirePacket<
+    WireConst<std::uint8_t, StartByte>,
+    WireField<&CommandObject::command, std::uint8_t>,
+    WireField<&CommandObject::command_src, std::uint8_t>,
+    WireField<&CommandObject::duration, std::uint16_t>,
+    WireField<&CommandObject::datetime, std::uint32_t>,
+    WireChecksum>;
+
+using HistorySchema = CommandSchema<HISTORY_STARTBYTE>;
+using ServerCommandSchema = CommandSchema<COMMAND_STARTBYTE>;
+
+// configs body, shared by both directions
+using DeviceConfigsBodySchema = WirePacket<
+    WireField<&DeviceConfig::qc_passed, std::uint8_t>,
+    WireField<&DeviceConfig::bvm_multiplier, float>,
+    WireField<&DeviceConfig::alarm1_working_time, std::uint16_t>,
+    WireField<&DeviceConfig::alarm1_on_time, std::uint16_t>,
+    WireField<&DeviceConfig::alarm1_off_time, std::uint16_t>,
+    WireField<&DeviceConfig::alarm2_working_time, std::uint16_t>,
+    WireField<&DeviceConfig::alarm2_on_time, std::uint16_t>,
+    WireField<&DeviceConfig::alarm2_off_time, std::uint16_t>,
+    WireText<&DeviceConfig::listener_address, LISTENER_ADDRESS_MAX_SIZE, STRING_DELIMITER>,
+    WireField<&DeviceConfig::listener_port, std::uint16_t>,
+    WireText<&DeviceConfig::sim1_apn, SIM_APN_MAX_SIZE, STRING_DELIMITER>,
+    WireText<&DeviceConfig::sim2_apn, SIM_APN_MAX_SIZE, STRING_DELIMITER>,
+    WireText<&DeviceConfig::sim1_username, SIM_USERNAME_MAX_SIZE, STRING_DELIMITER>,
+    WireText<&DeviceConfig::sim2_username, SIM_USERNAME_MAX_SIZE, STRING_DELIMITER>,
+    WireText<&DeviceConfig::sim1_password, SIM_PASSWORD_MAX_SIZE, STRING_DELIMITER>,
+    WireText<&DeviceConfig::sim2_password, SIM_PASSWORD_MAX_SIZE, STRING_DELIMITER>,
+    WireText<&DeviceConfig::dns_server_address, DNS_SERVER_ADDRESS_MAX_SIZE, STRING_DELIMITER>,
+    WireText<&DeviceConfig::alternative_dns_server_address, DNS_SERVER_ADDRESS_MAX_SIZE, STRING_DELIMITER>,
+    WireField<&DeviceConfig::call_sms_availability, std::uint8_t>,
+    WireRepeated<&DeviceConfig::phone_numbers_arr, std::uint8_t, PHONE_NUMBER_MAX_COUNT,
+        WireText<&PhoneNumber::number, PHONE_NUMBER_STR_MAX_SIZE, STRING_DELIMITER>,
+        WireFlags<&PhoneNumber::call, &PhoneNumber::sms>>>;
+
+// server -> device
+using DeviceConfigsSchema = WirePacket<
+    WireConst<std::uint8_t, SET_DEVICE_CONFIGS_STARTBYTE>,
+    WireLength<std::uint16_t>,
+    WireField<&DeviceConfig::update_time, std::uint32_t>,
+    DeviceConfigsBodySchema,
+    WireChecksum>;
+
+// device -> server
+using DeviceConfigsUploadSchema = WirePacket<
+    WireConst<std::uint8_t, GET_DEVICE_CONFIGS_PACKET_STARTBYTE>,
+    WireLength<std::uint16_t>,
+    DeviceConfigsBodySchema,
+    WireChecksum>;
+
+static_assert(HandshakeSchema::fixed && HandshakeSchema::size == HANDSHAKE_PACKET_SIZE);
+static_assert(PingSchema::fixed && PingSchema::size == PING_PACKET_SIZE);
+static_assert(HistorySchema::fixed && HistorySchema::size == HISTORY_PACKET_SIZE);
+static_assert(ServerCommandSchema::fixed && ServerCommandSchema::size == COMMAND_PACKET_SIZE);
+
+using PingTemplate = WireTemplate<PingSchema>;
+
+
+DeviceObject create_device_object(const std::uint64_t imei)
 {
-    if (str_max_size == 0)
-    {
-        throw std::runtime_error("Invalid string max size");
-    }
-
-    if (str.empty())
-    {
-        str.reserve(str_max_size);
-    }
-    else
-    {
-        str.clear();
-    }
-
-    for (std::uint8_t i = 0; i < str_max_size; ++i)
-    {
-        if (buff[bufiter] == delimiter)
-        {
-            ++bufiter;
-            break;
-        }
-        str.push_back(static_cast<char>(buff[bufiter++]));
-    }
-} // get_string_from_buffer
-
-void create_handshake_packet(std::uint8_t *buff, DeviceObject &device_object)
+    DeviceObject device_object{};
+    device_object.imei = imei;
+    device_object.firmware_major = DEVICE_FIRMWARE_MAJOR;
+    device_object.firmware_minor = DEVICE_FIRMWARE_MINOR;
+    device_object.firmware_patch = DEVICE_FIRMWARE_PATCH;
+
+    // state reported by pings
+    device_object.connection_type = connection_type_t::GSM;
+    device_object.phase_status = true;
+    device_object.battery_voltage = 13.74f;
+    device_object.sim1_present = true;
+    device_object.sim2_present = true;
+    device_object.active_sim = sim_t::SIM1;
+    device_object.sim1_signal_quality = 26;
+    device_object.sim2_signal_quality = 31;
+    device_object.active_command = command_t::ALARM1;
+    device_object.active_command_src = command_src_t::CALL;
+
+    return device_object;
+} // create_device_object
+
+void create_handshake_packet(std::uint8_t *buff, const DeviceObject &device_object)
 {
-    std::uintptr_t bufiter = 0;
-
-    // write start byte
-    *reinterpret_cast<uint16_t*>(buff + bufiter) = htobe16(HANDSHAKE_STARTBYTE);
-    bufiter += 2;
-
-    // write imei
-    *reinterpret_cast<uint64_t*>(buff + bufiter) = htobe64(device_object.imei);
-    bufiter += sizeof(device_object.imei);
-
-    // write firmware major
-    buff[bufiter++] = device_object.firmware_major;
-
-    // write firmware minor
-    buff[bufiter++] = device_object.firmware_minor;
-
-    // write a firmware patch
-    buff[bufiter++] = device_object.firmware_patch;
-
-    // count and write crc
-    *reinterpret_cast<uint16_t*>(buff + bufiter) = htobe16(std::accumulate(buff, buff + HANDSHAKE_PACKET_SIZE - 2, 0));
+    HandshakeSchema::encode(buff, device_object);
 } // create_handshake_packet
 
-void create_ping_packet(std::uint8_t *buff)
+void update_ping_packet(PingTemplate &ping, DeviceObject &device_object)
 {
-    // init ping params
-    std::uint32_t device_date_time = std::time(nullptr); // Fri Dec 30 2022 18:40:00 GMT+0000
-    std::uint8_t connection_type = 0x01; // GSM
-    std::uint8_t phase_status = 0x01; // true
-    std::uint16_t battery_voltage = 13740; // 13.74V
-    std::uint8_t sim_info = 0b00000011; // sim1 present, sim2 present, active sim is sim1
-    std::uint8_t sim1_signal_quality = 26;
-    std::uint8_t sim2_signal_quality = 31;
-    std::uint8_t active_command = 0x01; // ALARM1
-    std::uint8_t active_command_src = 0x03; // CALL
-
-    std::uintptr_t bufiter = 0;
-
-    // write start byte
-    buff[bufiter++] = PING_STARTBYTE;
-
-    // write device date time
-    *reinterpret_cast<std::uint32_t*>(buff + bufiter) = htobe32(device_date_time);
-    bufiter += sizeof(device_date_time);
-
-    // write a connection type
-    buff[bufiter++] = connection_type;
-
-    // write phase status
-    buff[bufiter++] = phase_status;
-
-    // write battery voltage
-    *reinterpret_cast<std::uint16_t*>(buff + bufiter) = htobe16(battery_voltage);
-    bufiter += sizeof(battery_voltage);
-
-    // write sim info
-    buff[bufiter++] = sim_info;
-
-    // write sim1 signal quality
-    buff[bufiter++] = sim1_signal_quality;
-
-    // write sim2 signal quality
-    buff[bufiter++] = sim2_signal_quality;
+    device_object.device_time = std::time(nullptr);
+    ping.patch<PingTime>(device_object);
+} // update_ping_packet
 
-    // write active command
-    buff[bufiter++] = active_command;
-
-    // write active command src
-    buff[bufiter++] = active_command_src;
-
-    // count and write crc
-    *reinterpret_cast<std::uint16_t*>(buff + bufiter) = htobe16(std::accumulate(buff, buff + PING_PACKET_SIZE - 2, 0));
-} // create_ping_packet
-
-void create_history_packet(std::uint8_t *buff)
+void create_history_packet(std::uint8_t *buff, const std::time_t datetime)
 {
     // init command
     CommandObject command{};
     command.command = command_t::ALARM1;
     command.command_src = command_src_t::CALL;
     command.duration = 60;
-    command.datetime = std::time(nullptr);
-
-    std::uintptr_t bufiter = 0;
-
-    // write start byte
-    buff[bufiter++] = HISTORY_STARTBYTE;
+    command.datetime = datetime;
 
-    // write command
-    buff[bufiter++] = static_cast<std::uint8_t>(command.command);
-
-    // write a command source
-    buff[bufiter++] = static_cast<std::uint8_t>(command.command_src);
-
-    // write a command duration
-    *reinterpret_cast<std::uint16_t*>(buff + bufiter) = htobe16(command.duration);
-    bufiter += sizeof(command.duration);
-
-    // write a command datetime
-    *reinterpret_cast<std::uint32_t*>(buff + bufiter) = htobe32(command.datetime);
-    bufiter += sizeof(std::uint32_t);
+    HistorySchema::encode(buff, command);
+}
 
-    // count and write crc
-    *reinterpret_cast<std::uint16_t*>(buff + bufiter) = htobe16(std::accumulate(buff, buff + HISTORY_PACKET_SIZE - 2, 0));
+void parse_command(const std::span<const std::uint8_t> packet, CommandObject &command)
+{
+    // the crc is not checked, as before
+    ServerCommandSchema::decode(packet, command);
 }
 
-void parse_command(const std::uint8_t *data, CommandObject &command)
+void parse_device_configs(const std::span<const std::uint8_t> packet, DeviceConfig &device_config)
 {
-    std::uintptr_t bufiter = 0;
+    const std::uint8_t *data = packet.data();
 
-    // read start byte
-    if (*data != COMMAND_STARTBYTE)
+    // check header size
+    if (packet.size() < DEVICE_CONFIGS_PACKET_HEADER_SIZE)
     {
-        throw std::runtime_error("Invalid start byte for command packet: " + std::to_string(*data));
+        throw std::runtime_error("Invalid device configs packet size: " + std::to_string(packet.size()));
     }
-    ++bufiter;
 
-    // read and check crc
-    std::uint16_t crc = be16toh(*reinterpret_cast<const std::uint16_t *>(data + COMMAND_PACKET_SIZE - 2));
-
-    // read command
-    command.command = static_cast<command_t>(data[bufiter++]);
-
-    // read a command source
-    command.command_src = static_cast<command_src_t>(data[bufiter++]);
-
-    // read a command duration
-    command.duration = be16toh(*reinterpret_cast<const std::uint16_t *>(data + bufiter));
-    bufiter += sizeof(command.duration);
-
-    // read a command datetime
-    command.datetime = be32toh(*reinterpret_cast<const std::uint32_t *>(data + bufiter));
-}
+    // read packet size
+    const std::uint16_t packet_size = wire_load<std::uint16_t>(data + 1);
 
-void parse_device_configs(const std::uint8_t *data, DeviceConfig &device_config)
-{
-    // check start byte
-    if (*data != SET_DEVICE_CONFIGS_STARTBYTE)
+    // check packet size
+    if (packet_size < sizeof(std::uint16_t) || packet.size() < packet_size + DEVICE_CONFIGS_PACKET_HEADER_SIZE)
     {
-        throw std::runtime_error("Invalid start byte for device configs packet: " + std::to_string(*data));
+        throw std::runtime_error("Device configs packet is truncated: " + std::to_string(packet.size()));
     }
 
-    // read packet size
-    std::uint16_t packet_size = be16toh(*reinterpret_cast<const std::uint16_t *>(data + 1));
-
     // read and check crc
-    std::uint16_t crc = be16toh(*reinterpret_cast<const std::uint16_t *>(data + packet_size + DEVICE_CONFIGS_PACKET_HEADER_SIZE - 2));
-    std::uint16_t real_crc = std::accumulate(data, data + packet_size + DEVICE_CONFIGS_PACKET_HEADER_SIZE - 2, 0);
+    const std::uint16_t crc = wire_load<std::uint16_t>(data + packet_size + DEVICE_CONFIGS_PACKET_HEADER_SIZE - 2);
+    const std::uint16_t real_crc = Checksum::compute(data, packet_size + DEVICE_CONFIGS_PACKET_HEADER_SIZE - 2);
     if (crc != real_crc)
     {
+        Metrics::add(Counter::CRC_FAILURES);
         throw std::runtime_error("Invalid crc for device configs packet: " +
                                  std::to_string(crc) + " != " + std::to_string(real_crc));
     }
 
-    std::uintptr_t bufiter = 3;
-
-    // read update time
-    device_config.update_time = be32toh(*reinterpret_cast<const std::uint32_t *>(data + bufiter));
-    bufiter += sizeof(std::uint32_t);
-
-    // read QC Passed
-    device_config.qc_passed = static_cast<bool>(data[bufiter++]);
-
-    // read BVM Multiplier
-    std::uint32_t tmp = be32toh(*reinterpret_cast<const std::uint32_t *>(data + bufiter));
-    std::memcpy(&device_config.bvm_multiplier, &tmp, sizeof(device_config.bvm_multiplier));
-    bufiter += sizeof(device_config.bvm_multiplier);
-
-    // read Alarm 1 Working Time
-    device_config.alarm1_working_time = be16toh(*reinterpret_cast<const std::uint16_t *>(data + bufiter));
-    bufiter += sizeof(device_config.alarm1_working_time);
-
-    // read Alarm 1 on time
-    device_config.alarm1_on_time = be16toh(*reinterpret_cast<const std::uint16_t *>(data + bufiter));
-    bufiter += sizeof(device_config.alarm1_on_time);
-
-    // read Alarm 1 off time
-    device_config.alarm1_off_time = be16toh(*reinterpret_cast<const std::uint16_t *>(data + bufiter));
-    bufiter += sizeof(device_config.alarm1_off_time);
-
-    // read Alarm 2 Working Time
-    device_config.alarm2_working_time = be16toh(*reinterpret_cast<const std::uint16_t *>(data + bufiter));
-    bufiter += sizeof(device_config.alarm2_working_time);
-
-    // read Alarm 2 on time
-    device_config.alarm2_on_time = be16toh(*reinterpret_cast<const std::uint16_t *>(data + bufiter));
-    bufiter += sizeof(device_config.alarm2_on_time);
-
-    // read Alarm 2 off time
-    device_config.alarm2_off_time = be16toh(*reinterpret_cast<const std::uint16_t *>(data + bufiter));
-    bufiter += sizeof(device_config.alarm2_off_time);
-
-    // read Listener Address
-    get_string_from_buffer(data, bufiter, device_config.listener_address, STRING_DELIMITER, LISTENER_ADDRESS_MAX_SIZE);
-
-    // read Listener Port
-    device_config.listener_port = be16toh(*reinterpret_cast<const std::uint16_t *>(data + bufiter));
-    bufiter += sizeof(device_config.listener_port);
-
-    // read Sim1 APN
-    get_string_from_buffer(data, bufiter, device_config.sim1_apn, STRING_DELIMITER, SIM_APN_MAX_SIZE);
-
-    // read Sim2 APN
-    get_string_from_buffer(data, bufiter, device_config.sim2_apn, STRING_DELIMITER, SIM_APN_MAX_SIZE);
-
-    // read Sim1 Username
-    get_string_from_buffer(data, bufiter, device_config.sim1_username, STRING_DELIMITER, SIM_USERNAME_MAX_SIZE);
-
-    // read Sim2 Username
-    get_string_from_buffer(data, bufiter, device_config.sim2_username, STRING_DELIMITER, SIM_USERNAME_MAX_SIZE);
-
-    // read Sim1 Password
-    get_string_from_buffer(data, bufiter, device_config.sim1_password, STRING_DELIMITER, SIM_PASSWORD_MAX_SIZE);
-
-    // read Sim2 Password
-    get_string_from_buffer(data, bufiter, device_config.sim2_password, STRING_DELIMITER, SIM_PASSWORD_MAX_SIZE);
-
-    // read DNS Server Address
-    get_string_from_buffer(data, bufiter, device_config.dns_server_address, STRING_DELIMITER, DNS_SERVER_ADDRESS_MAX_SIZE);
-
-    // read Alternative DNS Server Address
-    get_string_from_buffer(data, bufiter, device_config.alternative_dns_server_address, STRING_DELIMITER, DNS_SERVER_ADDRESS_MAX_SIZE);
-
-    // read Call SMS Availability
-    device_config.call_sms_availability = static_cast<bool>(data[bufiter++]);
-
-    // read phone number count
-    std::uint8_t phone_number_count = data[bufiter++];
-
-    // check phone numbers count
-    if (phone_number_count > PHONE_NUMBER_MAX_COUNT)
-    {
-        throw std::runtime_error("Invalid phone number count: " + std::to_string(phone_number_count));
-    }
-
-    // check if the phone numbers array is empty
-    // check if the phone numbers array is empty
-    if (!device_config.phone_numbers_arr.empty())
-    {
-        device_config.phone_numbers_arr.clear();
-    }
-
-    device_config.phone_numbers_arr.resize(phone_number_count);
-
-    // read phone numbers
-    for (std::uint8_t i = 0; i < phone_number_count; ++i)
-    {
-        // read phone number
-        get_string_from_buffer(data, bufiter, device_config.phone_numbers_arr[i].number, STRING_DELIMITER, PHONE_NUMBER_STR_MAX_SIZE);
-
-        // read SMS Availability
-        device_config.phone_numbers_arr[i].call = static_cast<bool>(data[bufiter] & static_cast<uint8_t>(0x01));
-
-        // read Call Availability
-        device_config.phone_numbers_arr[i].sms = static_cast<bool>((data[bufiter++] >> 1) & static_cast<uint8_t>(0x01));
-    }
+    DeviceConfigsSchema::decode(packet, device_config);
 }
 
-std::uint16_t create_device_configs(std::uint8_t *buff)
+std::size_t create_device_configs(std::uint8_t *buff)
 {
     // init device config
     DeviceConfig device_config{};
@@ -456,141 +347,53 @@ std::uint16_t create_device_configs(std::uint8_t *buff)
             PhoneNumber{"37455667788", true, true}
     };
 
-    // create a device configs packet
-    std::uintptr_t bufiter = 0;
-
-    // write start byte
-    buff[bufiter++] = GET_DEVICE_CONFIGS_PACKET_STARTBYTE;
-
-    // skip packet size
-    bufiter += sizeof(std::uint16_t);
-
-    // write qc passed
-    buff[bufiter++] = static_cast<std::uint8_t>(device_config.qc_passed);
-
-    // write bvm multiplier
-    std::uint32_t temp;
-    std::memcpy(&temp, &device_config.bvm_multiplier, sizeof(device_config.bvm_multiplier));
-    *reinterpret_cast<std::uint32_t*>(buff + bufiter) = htobe32(temp);
-    bufiter += sizeof(device_config.bvm_multiplier);
-
-    // write alarm1 working time
-    *reinterpret_cast<std::uint16_t*>(buff + bufiter) = htobe16(device_config.alarm1_working_time);
-    bufiter += sizeof(device_config.alarm1_working_time);
-
-    // write alarm1 on time
-    *reinterpret_cast<std::uint16_t*>(buff + bufiter) = htobe16(device_config.alarm1_on_time);
-    bufiter += sizeof(device_config.alarm1_on_time);
-
-    // write alarm1 off time
-    *reinterpret_cast<std::uint16_t*>(buff + bufiter) = htobe16(device_config.alarm1_off_time);
-    bufiter += sizeof(device_config.alarm1_off_time);
-
-    // write alarm2 working time
-    *reinterpret_cast<std::uint16_t*>(buff + bufiter) = htobe16(device_config.alarm2_working_time);
-    bufiter += sizeof(device_config.alarm2_working_time);
-
-    // write alarm2 on time
-    *reinterpret_cast<std::uint16_t*>(buff + bufiter) = htobe16(device_config.alarm2_on_time);
-    bufiter += sizeof(device_config.alarm2_on_time);
-
-    // write alarm2 off time
-    *reinterpret_cast<std::uint16_t*>(buff + bufiter) = htobe16(device_config.alarm2_off_time);
-    bufiter += sizeof(device_config.alarm2_off_time);
-
-    // write listener address
-    std::copy(device_config.listener_address.begin(), device_config.listener_address.end(), buff + bufiter);
-    bufiter += device_config.listener_address.size();
-    // write delimiter
-    buff[bufiter++] = STRING_DELIMITER;
-
-    // write listener port
-    *reinterpret_cast<std::uint16_t*>(buff + bufiter) = htobe16(device_config.listener_port);
-    bufiter += sizeof(device_config.listener_port);
-
-    // write sim1 apn
-    std::copy(device_config.sim1_apn.begin(), device_config.sim1_apn.end(), buff + bufiter);
-    bufiter += device_config.sim1_apn.size();
-    // write delimiter
-    buff[bufiter++] = STRING_DELIMITER;
-
-    // write sim2 apn
-    std::copy(device_config.sim2_apn.begin(), device_config.sim2_apn.end(), buff + bufiter);
-    bufiter += device_config.sim2_apn.size();
-    // write delimiter
-    buff[bufiter++] = STRING_DELIMITER;
-
-    // write sim1 username
-    std::copy(device_config.sim1_username.begin(), device_config.sim1_username.end(), buff + bufiter);
-    bufiter += device_config.sim1_username.size();
-    // write delimiter
-    buff[bufiter++] = STRING_DELIMITER;
-
-    // write sim2 username
-    std::copy(device_config.sim2_username.begin(), device_config.sim2_username.end(), buff + bufiter);
-    bufiter += device_config.sim2_username.size();
-    // write delimiter
-    buff[bufiter++] = STRING_DELIMITER;
-
-    // write sim1 password
-    std::copy(device_config.sim1_password.begin(), device_config.sim1_password.end(), buff + bufiter);
-    bufiter += device_config.sim1_password.size();
-    // write delimiter
-    buff[bufiter++] = STRING_DELIMITER;
-
-    // write sim2 password
-    std::copy(device_config.sim2_password.begin(), device_config.sim2_password.end(), buff + bufiter);
-    bufiter += device_config.sim2_password.size();
-    // write delimiter
-    buff[bufiter++] = STRING_DELIMITER;
-
-    // write dns server address
-    std::copy(device_config.dns_server_address.begin(), device_config.dns_server_address.end(), buff + bufiter);
-    bufiter += device_config.dns_server_address.size();
-    // write delimiter
-    buff[bufiter++] = STRING_DELIMITER;
-
-    // write alternative dns server address
-    std::copy(device_config.alternative_dns_server_address.begin(), device_config.alternative_dns_server_address.end(), buff + bufiter);
-    bufiter += device_config.alternative_dns_server_address.size();
-    // write delimiter
-    buff[bufiter++] = STRING_DELIMITER;
-
-    // write call sms availability
-    buff[bufiter++] = static_cast<std::uint8_t>(device_config.call_sms_availability);
-
-    // write phone number count
-    buff[bufiter++] = device_config.phone_numbers_arr.size();
-
-    // write phone numbers
-    for (auto & i : device_config.phone_numbers_arr)
-    {
-        // write phone number
-        std::copy(i.number.begin(), i.number.end(), buff + bufiter);
-        bufiter += i.number.size();
-        // write delimiter
-        buff[bufiter++] = STRING_DELIMITER;
+    // whole packet: start byte, size, body and crc
+    return DeviceConfigsUploadSchema::encode(buff, device_config);
+}
 
-        // write call availability
-        buff[bufiter] = static_cast<std::uint8_t>(i.call);
+AS3_Protocol::AS3_Protocol() :
+    imei(DEVICE_IMEI),
+    backlog(HISTORY_PACKET_SIZE)
+{}
 
-        // write sms availability
-        buff[bufiter++] |= static_cast<std::uint8_t>(i.sms) << 1;
+AS3_Protocol::AS3_Protocol(const std::uint64_t _imei, HistoryUpload _upload) :
+    imei(_imei),
+    upload(std::move(_upload)),
+    backlog(upload.journal ? HistoryBacklog(upload.journal, upload.slot, HISTORY_PACKET_SIZE) : HistoryBacklog(HISTORY_PACKET_SIZE))
+{
+    // check window
+    if (upload.window == 0)
+    {
+        throw std::invalid_argument("History window must be positive");
     }
 
-    // write packet size
-    *reinterpret_cast<std::uint16_t*>(buff + 1) = htobe16(bufiter - DEVICE_CONFIGS_PACKET_HEADER_SIZE + 2);
+    fill_backlog();
+}
+
+std::size_t AS3_Protocol::history_record_size()
+{
+    return HISTORY_PACKET_SIZE;
+}
 
-    // count and write crc
-    std::uint16_t crc = std::accumulate(buff, buff + bufiter, 0);
-    *reinterpret_cast<std::uint16_t*>(buff + bufiter) = htobe16(crc);
-    bufiter += sizeof(std::uint16_t);
-    
-    return bufiter;
+void AS3_Protocol::fill_backlog()
+{
+    // events of a device that was offline, oldest first; a journal keeps them after what it resumed
+    std::array<std::uint8_t, HISTORY_PACKET_SIZE> record{};
+    const std::time_t now = std::time(nullptr);
+    for (std::size_t i = upload.backlog; i > 0; --i)
+    {
+        create_history_packet(record.data(), now - static_cast<std::time_t>((i - 1) * HISTORY_EVENT_SPACING_S));
+        backlog.push(record);
+    }
 }
 
-AS3_Protocol::AS3_Protocol()
+SocketOptions AS3_Protocol::socket_options() const
 {
+    // 16-byte pings and history records wait for each ack, Nagle would hold them back
+    SocketOptions options;
+    options.no_delay = true;
+    options.quick_ack = true;
+    return options;
 }
 
 void AS3_Protocol::handler_loop(int _socket_fd)
@@ -601,11 +404,7 @@ void AS3_Protocol::handler_loop(int _socket_fd)
     socket_fd = _socket_fd;
 
     // init device object
-    DeviceObject device_object{};
-    device_object.imei = 862686042898620;
-    device_object.firmware_major = 1;
-    device_object.firmware_minor = 2;
-    device_object.firmware_patch = 10;
+    DeviceObject device_object = create_device_object(imei);
 
     // init buffer
     std::array<std::uint8_t, 1024> buffer{};
@@ -621,6 +420,7 @@ void AS3_Protocol::handler_loop(int _socket_fd)
     catch (const std::exception& e)
     {
         std::cerr << "Error sending handshake packet: " << e.what() << std::endl;
+        Metrics::add(Counter::HANDSHAKES_FAILED);
         return;
     }
 
@@ -632,27 +432,34 @@ void AS3_Protocol::handler_loop(int _socket_fd)
     catch (const std::exception& e)
     {
         std::cerr << "Error reading handshake response: " << e.what() << std::endl;
+        Metrics::add(Counter::HANDSHAKES_FAILED);
         return;
     }
 
     // check handshake response
-    std::time_t server_time = be32toh(*reinterpret_cast<std::uint32_t*>(buffer.data()));
+    std::time_t server_time = wire_load<std::uint32_t>(buffer.data());
     std::cout << "Server time: " << server_time << std::endl;
     if (server_time == 0)
     {
         std::cerr << "Server time is 0" << std::endl;
+        Metrics::add(Counter::HANDSHAKES_FAILED);
         return;
     }
+    Metrics::add(Counter::HANDSHAKES_OK);
+
+    // encode the ping once, only its time changes
+    PingTemplate ping(device_object);
 
     for (;;)
     {
-        // create a ping packet
-        create_ping_packet(buffer.data());
+        // update the ping packet
+        update_ping_packet(ping, device_object);
+        const auto ping_sent = clock::now();
 
         // send ping packet
         try
         {
-            send_data(buffer.data(), PING_PACKET_SIZE);
+            send_data(ping.data(), ping.size());
         }
         catch (const std::exception& e)
         {
@@ -677,6 +484,7 @@ void AS3_Protocol::handler_loop(int _socket_fd)
             std::cerr << "Ping response is not OK" << std::endl;
             return;
         }
+        LatencyRecorder::record(LatencyMetric::AS3_PING, clock::now() - ping_sent);
 
         std::cout << "Input mode (1 - ping, 2 - send history, 3 - read command, 4 - rcv device configs, 5 - get device configs)" << std::endl;
         std::cin >> buffer[0];
@@ -691,7 +499,8 @@ void AS3_Protocol::handler_loop(int _socket_fd)
             case '2':
             {
                 // create a history packet
-                create_history_packet(buffer.data());
+                create_history_packet(buffer.data(), std::time(nullptr));
+                const auto history_sent = clock::now();
 
                 // send a history packet
                 try {
@@ -716,15 +525,20 @@ void AS3_Protocol::handler_loop(int _socket_fd)
                     std::cerr << "History response is not OK" << std::endl;
                     return;
                 }
+                LatencyRecorder::record(LatencyMetric::AS3_HISTORY, clock::now() - history_sent);
 
                 continue;
             } // end case '2'
 
             case '3':
             {
+                // read command packet and parse it in place
+                CommandObject command{};
                 try
                 {
-                    recv_data(buffer.data(), COMMAND_PACKET_SIZE);
+                    const auto packet = recv_view(COMMAND_PACKET_SIZE);
+                    parse_command(packet, command);
+                    consume(packet.size());
                 }
                 catch (const std::exception& e)
                 {
@@ -732,9 +546,6 @@ void AS3_Protocol::handler_loop(int _socket_fd)
                     return;
                 }
 
-                CommandObject command{};
-                parse_command(buffer.data(), command);
-
                 // send response
                 buffer[0] = OK_DATA;
                 try
@@ -757,24 +568,20 @@ void AS3_Protocol::handler_loop(int _socket_fd)
 
             case '4':
             {
-                // rcv device configs header
+                DeviceConfig device_config{};
+
                 try
                 {
-                    recv_data(buffer.data(), DEVICE_CONFIGS_PACKET_HEADER_SIZE);
-                }
-                catch (const std::exception& e)
-                {
-                    std::cerr << "Error reading device configs header: " << e.what() << std::endl;
-                    return;
-                }
+                    // rcv device configs header
+                    const auto header = recv_view(DEVICE_CONFIGS_PACKET_HEADER_SIZE);
 
-                // read packet size
-                std::uint16_t packet_size = be16toh(*reinterpret_cast<const std::uint16_t*>(buffer.data() + 1));
+                    // read packet size
+                    const std::uint16_t packet_size = wire_load<std::uint16_t>(header.data() + 1);
 
-                // read device configs
-                try
-                {
-                    recv_data(buffer.data() + DEVICE_CONFIGS_PACKET_HEADER_SIZE, packet_size);
+                    // rcv the whole packet and parse it in place
+                    const auto packet = recv_view(DEVICE_CONFIGS_PACKET_HEADER_SIZE + packet_size);
+                    parse_device_configs(packet, device_config);
+                    consume(packet.size());
                 }
                 catch (const std::exception& e)
                 {
@@ -782,9 +589,6 @@ void AS3_Protocol::handler_loop(int _socket_fd)
                     return;
                 }
 
-                DeviceConfig device_config{};
-                parse_device_configs(buffer.data(), device_config);
-
                 // send response
                 buffer[0] = OK_DATA;
                 try
@@ -850,9 +654,10 @@ void AS3_Protocol::handler_loop(int _socket_fd)
                 }
 
                 // create a device configs packet
-                std::uint16_t packet_size = create_device_configs(buffer.data());
+                static_assert(DeviceConfigsUploadSchema::size <= buffer.size());
+                const std::size_t packet_size = create_device_configs(buffer.data());
 
-                // send a device configs packet
+                // send it
                 try
                 {
                     send_data(buffer.data(), packet_size);
@@ -875,13 +680,110 @@ void AS3_Protocol::handler_loop(int _socket_fd)
                 }
 
                 // check response
-                std::cout << "Device configs response: " << be32toh(*reinterpret_cast<std::uint32_t*>(buffer.data())) << std::endl;
+                std::cout << "Device configs response: " << wire_load<std::uint32_t>(buffer.data()) << std::endl;
 
                 continue;
             } // end case '5'
         } // end switch (buffer[0])
 
-        sleep(30);
+        sleep(PING_INTERVAL);
 
     } // for (;;)
-}
\ No newline at end of file
+}
+
+Task AS3_Protocol::session()
+{
+    // init device object
+    DeviceObject device_object = create_device_object(imei);
+
+    // init buffer
+    std::array<std::uint8_t, 64> buffer{};
+
+    // create and send a handshake packet
+    create_handshake_packet(buffer.data(), device_object);
+    try
+    {
+        co_await async_send(buffer.data(), HANDSHAKE_PACKET_SIZE);
+
+        // read handshake response
+        co_await async_recv(buffer.data(), 4);
+    }
+    catch (const std::exception&)
+    {
+        Metrics::add(Counter::HANDSHAKES_FAILED);
+        throw;
+    }
+
+    // check handshake response
+    const std::time_t server_time = wire_load<std::uint32_t>(buffer.data());
+    if (server_time == 0)
+    {
+        Metrics::add(Counter::HANDSHAKES_FAILED);
+        throw std::runtime_error("Server time is 0");
+    }
+    Metrics::add(Counter::HANDSHAKES_OK);
+
+    // flush the history kept while offline before the first ping
+    co_await upload_history();
+
+    // encode the ping once, only its time changes
+    PingTemplate ping(device_object);
+
+    for (;;)
+    {
+        // update and send the ping packet
+        update_ping_packet(ping, device_object);
+        const auto ping_sent = clock::now();
+        co_await async_send(ping.data(), ping.size());
+
+        // read one byte
+        co_await async_recv(buffer.data(), 1);
+
+        // check response
+        if (buffer[0] != OK_DATA)
+        {
+            throw std::runtime_error("Ping response is not OK");
+        }
+        LatencyRecorder::record(LatencyMetric::AS3_PING, clock::now() - ping_sent);
+
+        co_await sleep_for(jittered(std::chrono::seconds(PING_INTERVAL), PING_JITTER_PERCENT));
+    } // for (;;)
+}
+
+Task AS3_Protocol::upload_history()
+{
+    // sent but not acked, the oldest records of the backlog
+    std::size_t sent = 0;
+    std::deque<clock::time_point> sent_times;
+    std::uint8_t ack = 0;
+
+    // acks of a whole window may arrive while the coroutine still sends
+    rx_buffer.reserve(upload.window);
+
+    while (!backlog.empty())
+    {
+        // top up the window, a run of records goes out in one send
+        while (sent < upload.window && sent < backlog.size())
+        {
+            const auto run = backlog.peek(sent, upload.window - sent);
+            co_await async_send(run.data(), run.size());
+
+            const std::size_t records = run.size() / HISTORY_PACKET_SIZE;
+            sent_times.insert(sent_times.end(), records, clock::now());
+            sent += records;
+        }
+
+        // acks come back in order, each one for the oldest record in flight
+        co_await async_recv(&ack, 1);
+        if (ack != OK_DATA)
+        {
+            throw std::runtime_error("History response is not OK");
+        }
+        LatencyRecorder::record(LatencyMetric::AS3_HISTORY, clock::now() - sent_times.front());
+        Metrics::add(Counter::HISTORY_ACKED);
+
+        sent_times.pop_front();
+        backlog.pop(1);
+        --sent;
+    }
+}
@@ -0,0 +1,131 @@
+#include "AbstractCoroutineProtocol.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+
+void AbstractCoroutineProtocol::on_connected(const int _socket_fd)
+{
+    AbstractProtocol::on_connected(_socket_fd);
+
+    // drop the previous session coroutine
+    waiting = nullptr;
+    wait_reason = WaitReason::NONE;
+
+    // run session until the first suspension
+    task = session();
+    task.start();
+
+    if (task.done())
+    {
+        task.rethrow_if_failed();
+        close_session();
+    }
+}
+
+void AbstractCoroutineProtocol::suspend(const std::coroutine_handle<> _handle, const WaitReason reason)
+{
+    if (waiting)
+    {
+        throw std::logic_error("Session coroutine is already waiting");
+    }
+
+    waiting = _handle;
+    wait_reason = reason;
+}
+
+void AbstractCoroutineProtocol::resume(const WaitReason reason)
+{
+    if (!waiting || wait_reason != reason)
+    {
+        return;
+    }
+
+    // resume the awaiting coroutine, it runs until the next suspension
+    wait_reason = WaitReason::NONE;
+    std::exchange(waiting, nullptr).resume();
+
+    // check session result
+    if (task.done())
+    {
+        task.rethrow_if_failed();
+        close_session();
+    }
+}
+
+void AbstractCoroutineProtocol::receive(uint8_t* data, const size_t size)
+{
+    const uint8_t* message = rx_buffer.peek(size).data();
+    record_received(message, size);
+    std::memcpy(data, message, size);
+    consume(size);
+}
+
+void AbstractCoroutineProtocol::on_data()
+{
+    // bytes nobody waits for yet stay buffered, e.g. acks arriving during a send
+    if (wait_reason == WaitReason::RECV && rx_buffer.size() >= rx_expected)
+    {
+        // the awaitable takes the message when it resumes
+        rx_expected = 0;
+        resume(WaitReason::RECV);
+    }
+}
+
+void AbstractCoroutineProtocol::on_timer()
+{
+    resume(WaitReason::SLEEP);
+}
+
+void AbstractCoroutineProtocol::on_drained()
+{
+    resume(WaitReason::SEND);
+}
+
+
+AbstractCoroutineProtocol::RecvAwaitable AbstractCoroutineProtocol::async_recv(void* data, const size_t size)
+{
+    if (data == nullptr)
+    {
+        throw std::invalid_argument("Buffer must not be nullptr");
+    }
+
+    return {*this, static_cast<uint8_t*>(data), size};
+}
+
+AbstractCoroutineProtocol::SendAwaitable AbstractCoroutineProtocol::async_send(const void* data, const size_t size)
+{
+    return {*this, data, size};
+}
+
+AbstractCoroutineProtocol::SleepAwaitable AbstractCoroutineProtocol::sleep_for(const clock::duration delay)
+{
+    return {*this, delay};
+}
+
+
+void AbstractCoroutineProtocol::RecvAwaitable::await_suspend(const std::coroutine_handle<> _handle) const
+{
+    protocol.suspend(_handle, WaitReason::RECV);
+    protocol.expect(size);
+}
+
+bool AbstractCoroutineProtocol::SendAwaitable::await_suspend(const std::coroutine_handle<> _handle) const
+{
+    protocol.queue_data(data, size);
+
+    // don't suspend if everything went out right away
+    if (!protocol.wants_write())
+    {
+        return false;
+    }
+
+    protocol.suspend(_handle, WaitReason::SEND);
+    return true;
+}
+
+void AbstractCoroutineProtocol::SleepAwaitable::await_suspend(const std::coroutine_handle<> _handle) const
+{
+    protocol.suspend(_handle, WaitReason::SLEEP);
+    protocol.set_timer(delay);
+}
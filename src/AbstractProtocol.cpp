@@ -0,0 +1,483 @@
+#include "AbstractProtocol.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <sys/socket.h>
+
+
+#define SEND_MAX_PARTS          (8U) // deferred data + caller parts per sendmsg
+
+
+void AbstractProtocol::wait_socket(const short events, const int timeout_ms) const
+{
+    pollfd poll_fd{socket_fd, events, 0};
+
+    for (;;)
+    {
+        const int result = poll(&poll_fd, 1, timeout_ms);
+
+        // check return value
+        if (result > 0)
+        {
+            return;
+        }
+        if (result == 0)
+        {
+            Metrics::add(Counter::TIMEOUTS);
+            throw std::runtime_error("Resource temporarily unavailable: timeout !!");
+        }
+        if (errno != EINTR)
+        {
+            throw std::runtime_error("Error waiting socket: " + std::string(strerror(errno)));
+        }
+    }
+}
+
+
+std::span<const uint8_t> AbstractProtocol::recv_view(const size_t size)
+{
+    Logger::log<LogLevel::Debug>("Reading bytes:", size);
+
+    ssize_t bytes_received = 0;
+    ssize_t result;
+
+    // check size
+    if (size == 0)
+    {
+        throw std::invalid_argument("Invalid size");
+    }
+    if (size > static_cast<size_t>(INT_MAX))
+    {
+        throw std::out_of_range("Size too big");
+    }
+
+    // make room for the whole message
+    rx_buffer.reserve(size);
+
+    while (rx_buffer.size() < size)
+    {
+        // rcv everything the socket holds, the rest stays buffered for the next call
+        result = rx_buffer.fill(socket_fd, RECV_FLAGS);
+
+        // check return value
+        if (result == 0)
+        {
+            break;
+        }
+        else if (result < 0)
+        {
+            switch (errno)
+            {
+                case EINTR:
+                    Logger::log<LogLevel::Debug>("Interrupted system call, retrying...");
+                    continue;
+
+                case EAGAIN:
+#ifdef NON_BLOCKING
+                    // wait until the socket is readable
+                    wait_socket(POLLIN, IO_WAIT_TIMEOUT_MS);
+                    continue;
+#else
+                    Metrics::add(Counter::TIMEOUTS);
+                    throw std::runtime_error("Resource temporarily unavailable: timeout !!");
+#endif // NON_BLOCKING
+
+                default:
+                    throw std::runtime_error("Error receiving data: " + std::string(strerror(errno)));
+            }
+        }
+    } // while
+
+    bytes_received = static_cast<ssize_t>(std::min(size, rx_buffer.size()));
+
+    // check bytes received
+    if (bytes_received <= 0 || bytes_received > INT_MAX)
+    {
+        throw std::out_of_range("Invalid bytes received: " + std::to_string(bytes_received));
+    }
+    if (bytes_received != static_cast<ssize_t>(size))
+    {
+        throw std::runtime_error("Reading data failed, received: " + std::to_string(bytes_received));
+    }
+
+    // frame stays in the receive buffer until consume()
+    const std::span<const uint8_t> frame = rx_buffer.peek(size);
+
+    // log data
+    log_buffer_hex(frame.data(), frame.size());
+    const iovec part{const_cast<uint8_t*>(frame.data()), frame.size()};
+    record_frame(CaptureDirection::RECEIVED, &part, 1);
+
+    return frame;
+}
+
+ssize_t AbstractProtocol::send_data(const std::initializer_list<iovec> parts)
+{
+    // fixed part table, no allocation on the send path
+    std::array<iovec, SEND_MAX_PARTS> segments{};
+    size_t count = 0;
+
+    // deferred data goes first
+    if (!tx_deferred.empty())
+    {
+        segments[count++] = {tx_deferred.data(), tx_deferred.size()};
+    }
+
+    size_t size = 0;
+    for (const iovec& part : parts)
+    {
+        // check buffer
+        if (part.iov_base == nullptr && part.iov_len > 0)
+        {
+            throw std::invalid_argument("Buffer must not be nullptr");
+        }
+        if (part.iov_len == 0)
+        {
+            continue;
+        }
+        if (count == segments.size())
+        {
+            throw std::out_of_range("Too many parts: " + std::to_string(parts.size()));
+        }
+        segments[count++] = part;
+    }
+    for (size_t i = 0; i < count; ++i)
+    {
+        size += segments[i].iov_len;
+    }
+
+    Logger::log<LogLevel::Debug>("Sending bytes:", size);
+
+    // check size
+    if (size == 0)
+    {
+        throw std::invalid_argument("Invalid size");
+    }
+    if (size > static_cast<size_t>(INT_MAX))
+    {
+        throw std::out_of_range("Size too big");
+    }
+
+    // keep a copy of the parts for logging, sendmsg moves the segments
+    const std::array<iovec, SEND_MAX_PARTS> logged = segments;
+
+    ssize_t bytes_sent = 0;
+    size_t index = 0;
+
+    while (index < count)
+    {
+        msghdr message{};
+        message.msg_iov = segments.data() + index;
+        message.msg_iovlen = count - index;
+
+        // send all parts with one call
+        const ssize_t result = sendmsg(socket_fd, &message, SEND_FLAGS);
+
+        // check return value
+        if (result == 0)
+        {
+            break;
+        }
+        else if (result < 0)
+        {
+            switch (errno)
+            {
+                case EINTR:
+                    Logger::log<LogLevel::Debug>("Interrupted system call, retrying...");
+                    continue;
+
+                case EAGAIN:
+#ifdef NON_BLOCKING
+                    // wait until the socket is writable
+                    wait_socket(POLLOUT, IO_WAIT_TIMEOUT_MS);
+                    continue;
+#else
+                    Metrics::add(Counter::TIMEOUTS);
+                    throw std::runtime_error("Resource temporarily unavailable: timeout !!");
+#endif // NON_BLOCKING
+
+                default:
+                    throw std::runtime_error("Error sending data: " + std::string(strerror(errno)));
+            }
+        }
+
+        bytes_sent += result;
+
+        // skip fully sent parts and move into a partially sent one
+        size_t left = result;
+        while (index < count && left >= segments[index].iov_len)
+        {
+            left -= segments[index].iov_len;
+            ++index;
+        }
+        if (left > 0)
+        {
+            segments[index].iov_base = static_cast<uint8_t*>(segments[index].iov_base) + left;
+            segments[index].iov_len -= left;
+        }
+    } // while
+
+    // check bytes sent
+    if (bytes_sent != static_cast<ssize_t>(size))
+    {
+        throw std::runtime_error("Sending data failed, sent: " + std::to_string(bytes_sent));
+    }
+
+    tx_deferred.clear();
+
+    // log data
+    for (size_t i = 0; i < count; ++i)
+    {
+        log_buffer_hex(static_cast<const uint8_t*>(logged[i].iov_base), logged[i].iov_len);
+    }
+    record_frame(CaptureDirection::SENT, logged.data(), count);
+
+    return bytes_sent;
+}
+
+void AbstractProtocol::record_frame(const CaptureDirection direction, const iovec* parts, const size_t count) const
+{
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        size += parts[i].iov_len;
+    }
+    Metrics::add_frame(static_cast<uint16_t>(protocol_id()), direction, size);
+
+    if (Capture::enabled())
+    {
+        Capture::record(direction, session_id, static_cast<uint16_t>(protocol_id()), parts, count);
+    }
+}
+
+void AbstractProtocol::defer_send(const void* data, const size_t size)
+{
+    if (data == nullptr || size == 0)
+    {
+        throw std::invalid_argument("Invalid data to defer");
+    }
+
+    // copy, the caller may reuse its buffer before the next send
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    tx_deferred.insert(tx_deferred.end(), bytes, bytes + size);
+}
+
+
+void AbstractProtocol::attach(const int _socket_fd)
+{
+    socket_fd = _socket_fd;
+
+    // reset buffers and event state
+    rx_buffer.clear();
+    tx_deferred.clear();
+    rx_expected = 0;
+    tx_buffer.clear();
+    tx_offset = 0;
+    timer_deadline = {};
+    closing = false;
+}
+
+void AbstractProtocol::on_connected(const int _socket_fd)
+{
+    attach(_socket_fd);
+}
+
+void AbstractProtocol::on_readable()
+{
+    // room for the expected message, the ring does not grow for data nobody asked for
+    rx_buffer.reserve(std::max<size_t>(rx_expected, 1));
+    if (rx_buffer.free_space() == 0)
+    {
+        throw std::runtime_error("Receive buffer full: " + std::to_string(rx_buffer.size()) + " bytes");
+    }
+
+    // one read, epoll is level-triggered and reports the rest again
+    for (;;)
+    {
+        const ssize_t result = rx_buffer.fill(socket_fd, RECV_FLAGS);
+
+        if (result > 0)
+        {
+            break;
+        }
+
+        if (result == 0)
+        {
+            throw std::runtime_error("Connection closed by peer");
+        }
+
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return;
+        }
+
+        throw std::runtime_error("Error receiving data: " + std::string(strerror(errno)));
+    } // for (;;)
+
+    // hand new data to the protocol
+    on_data();
+}
+
+void AbstractProtocol::on_writable()
+{
+    while (wants_write())
+    {
+        const ssize_t result = send(socket_fd, pending_data(), pending_size(), SEND_FLAGS | MSG_NOSIGNAL);
+
+        if (result >= 0)
+        {
+            on_sent(result);
+            continue;
+        }
+
+        if (errno == EINTR)
+        {
+            continue;
+        }
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+        {
+            return;
+        }
+
+        throw std::runtime_error("Error sending data: " + std::string(strerror(errno)));
+    }
+}
+
+void AbstractProtocol::on_received(const uint8_t* data, const size_t size)
+{
+    rx_buffer.append(data, size);
+    on_data();
+}
+
+void AbstractProtocol::on_sent(const size_t size)
+{
+    if (size > pending_size())
+    {
+        throw std::out_of_range("Sent size too big: " + std::to_string(size));
+    }
+
+    log_buffer_hex(pending_data(), size);
+    const iovec part{const_cast<uint8_t*>(pending_data()), size};
+    record_frame(CaptureDirection::SENT, &part, 1);
+    tx_offset += size;
+
+    // everything is flushed
+    if (!wants_write())
+    {
+        tx_buffer.clear();
+        tx_offset = 0;
+
+        on_drained();
+    }
+}
+
+void AbstractProtocol::on_data()
+{
+    // deliver every complete message, a partial one stays buffered until the next read
+    while (rx_expected > 0 && rx_buffer.size() >= rx_expected)
+    {
+        const size_t size = rx_expected;
+        rx_expected = 0;
+
+        const uint8_t* message = rx_buffer.peek(size).data();
+        record_received(message, size);
+
+        // the handler may call expect() for the next message
+        on_message(message, size);
+        consume(size);
+
+        if (closing)
+        {
+            return;
+        }
+    }
+
+    // check unexpected data
+    if (rx_expected == 0 && !rx_buffer.empty())
+    {
+        throw std::runtime_error("Unexpected data: " + std::to_string(rx_buffer.size()) + " bytes");
+    }
+}
+
+void AbstractProtocol::record_received(const uint8_t* data, const size_t size) const
+{
+    log_buffer_hex(data, size);
+    const iovec part{const_cast<uint8_t*>(data), size};
+    record_frame(CaptureDirection::RECEIVED, &part, 1);
+}
+
+void AbstractProtocol::on_message(const uint8_t*, size_t)
+{
+    throw std::logic_error("Protocol does not handle messages");
+}
+
+void AbstractProtocol::expect(const size_t size)
+{
+    if (size == 0)
+    {
+        throw std::invalid_argument("Invalid size");
+    }
+
+    rx_expected = size;
+}
+
+void AbstractProtocol::queue_data(const void* data, const size_t size)
+{
+    if (data == nullptr || size == 0)
+    {
+        throw std::invalid_argument("Invalid data to queue");
+    }
+
+    const bool was_empty = !wants_write();
+
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    tx_buffer.insert(tx_buffer.end(), bytes, bytes + size);
+
+    // try to send right away, the rest goes out on EPOLLOUT
+    if (was_empty && !deferred_io)
+    {
+        on_writable();
+    }
+}
+
+void AbstractProtocol::consume(const size_t size)
+{
+    rx_buffer.consume(size);
+}
+
+void AbstractProtocol::set_timer(const clock::duration delay)
+{
+    timer_deadline = clock::now() + delay;
+}
+
+AbstractProtocol::clock::duration AbstractProtocol::jittered(const clock::duration period, const unsigned percent)
+{
+    thread_local std::minstd_rand generator{std::random_device{}()};
+
+    const auto spread = period.count() * static_cast<clock::rep>(percent) / 100;
+    if (spread <= 0)
+    {
+        return period;
+    }
+
+    std::uniform_int_distribution<clock::rep> distribution(-spread, spread);
+    return clock::duration(period.count() + distribution(generator));
+}
+
+void AbstractProtocol::close_session()
+{
+    closing = true;
+}
+
+void AbstractProtocol::on_timer_expired()
+{
+    // disarm before the callback so the protocol can re-arm it
+    timer_deadline = {};
+    on_timer();
+}
@@ -0,0 +1,171 @@
+#include "Capture.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "Logger.hpp"
+
+
+#define CAPTURE_GROW_SIZE               (64ULL << 20) // file grows in 64 MiB steps
+#define CAPTURE_MAX_SIZE                (1ULL << 40)  // reserved address space
+
+
+std::atomic<Capture*> Capture::active{nullptr};
+
+
+Capture::Capture(const std::string& _path)
+{
+    // create capture file
+    if ((file_fd = ::open(_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)) < 0)
+    {
+        throw std::runtime_error("Capture file open failed: " + std::string(strerror(errno)));
+    }
+
+    // reserve address space, file chunks are mapped into it as it grows
+    void* region = mmap(nullptr, CAPTURE_MAX_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (region == MAP_FAILED)
+    {
+        const std::string error = strerror(errno);
+        ::close(file_fd);
+        throw std::runtime_error("Capture reserve failed: " + error);
+    }
+    base = static_cast<uint8_t*>(region);
+    reserved_size = CAPTURE_MAX_SIZE;
+
+    try
+    {
+        grow(sizeof(CaptureFileHeader));
+    }
+    catch (...)
+    {
+        munmap(base, reserved_size);
+        ::close(file_fd);
+        throw;
+    }
+
+    // write file header
+    CaptureFileHeader header{};
+    std::memcpy(header.magic, CAPTURE_MAGIC, sizeof(header.magic));
+    header.version = CAPTURE_VERSION;
+    header.record_header_size = sizeof(CaptureRecordHeader);
+    std::memcpy(base, &header, sizeof(header));
+
+    write_offset = sizeof(CaptureFileHeader);
+}
+
+Capture::~Capture()
+{
+    munmap(base, reserved_size);
+
+    // cut the unused tail of the last chunk, readers stop at a zero tail anyway
+    if (ftruncate(file_fd, static_cast<off_t>(write_offset.load())) < 0) {}
+    ::close(file_fd);
+}
+
+
+void Capture::open(const std::string& _path)
+{
+    auto* capture = new Capture(_path);
+
+    // replace the capture of an earlier -c, nothing records yet
+    delete active.exchange(capture);
+}
+
+void Capture::close()
+{
+    delete active.exchange(nullptr);
+}
+
+void Capture::record(const CaptureDirection _direction, const uint32_t _session_id, const uint16_t _protocol_id, const iovec* _parts, const size_t _count)
+{
+    Capture* capture = active.load(std::memory_order_acquire);
+    if (capture == nullptr || capture->failed.load(std::memory_order_relaxed))
+    {
+        return;
+    }
+
+    try
+    {
+        capture->append(_direction, _session_id, _protocol_id, _parts, _count);
+    }
+    catch (const std::exception& e)
+    {
+        // capture is a side channel, the session keeps going without it
+        if (!capture->failed.exchange(true))
+        {
+            Logger::log<LogLevel::Error>("Capture disabled after bytes:", capture->write_offset.load(std::memory_order_relaxed), e.what());
+        }
+    }
+}
+
+
+void Capture::grow(const size_t _size)
+{
+    std::lock_guard<std::mutex> lock(grow_mutex);
+
+    size_t mapped = mapped_size.load(std::memory_order_relaxed);
+    while (mapped < _size)
+    {
+        if (mapped + CAPTURE_GROW_SIZE > reserved_size)
+        {
+            throw std::runtime_error("Capture file is full");
+        }
+
+        // extend the file and map the new chunk right after the previous one
+        if (ftruncate(file_fd, static_cast<off_t>(mapped + CAPTURE_GROW_SIZE)) < 0)
+        {
+            throw std::runtime_error("Capture file resize failed: " + std::string(strerror(errno)));
+        }
+        if (mmap(base + mapped, CAPTURE_GROW_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, file_fd, static_cast<off_t>(mapped)) == MAP_FAILED)
+        {
+            throw std::runtime_error("Capture file map failed: " + std::string(strerror(errno)));
+        }
+
+        mapped += CAPTURE_GROW_SIZE;
+        mapped_size.store(mapped, std::memory_order_release);
+    }
+}
+
+void Capture::append(const CaptureDirection _direction, const uint32_t _session_id, const uint16_t _protocol_id, const iovec* _parts, const size_t _count)
+{
+    size_t size = 0;
+    for (size_t i = 0; i < _count; ++i)
+    {
+        size += _parts[i].iov_len;
+    }
+
+    // reserve the record once it is mapped, a failed grow leaves no hole behind
+    const size_t record_size = sizeof(CaptureRecordHeader) + ((size + CAPTURE_RECORD_ALIGN - 1) & ~static_cast<size_t>(CAPTURE_RECORD_ALIGN - 1));
+    size_t offset = write_offset.load(std::memory_order_relaxed);
+    do
+    {
+        if (offset + record_size > mapped_size.load(std::memory_order_acquire))
+        {
+            grow(offset + record_size);
+        }
+    } while (!write_offset.compare_exchange_weak(offset, offset + record_size, std::memory_order_relaxed));
+
+    timespec now{};
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    // unwritten space stays zero, readers stop at a record with zero size
+    uint8_t* destination = base + offset + sizeof(CaptureRecordHeader);
+    for (size_t i = 0; i < _count; ++i)
+    {
+        std::memcpy(destination, _parts[i].iov_base, _parts[i].iov_len);
+        destination += _parts[i].iov_len;
+    }
+
+    CaptureRecordHeader header{};
+    header.timestamp_ns = static_cast<uint64_t>(now.tv_sec) * 1000000000ULL + static_cast<uint64_t>(now.tv_nsec);
+    header.session_id = _session_id;
+    header.size = static_cast<uint32_t>(size);
+    header.protocol_id = _protocol_id;
+    header.direction = static_cast<uint8_t>(_direction);
+    std::memcpy(base + offset, &header, sizeof(header));
+}
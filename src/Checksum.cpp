@@ -0,0 +1,114 @@
+#include "Checksum.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif // __x86_64__
+
+
+#define CHECKSUM_SIMD_MIN_SIZE          (32U) // shorter buffers are summed byte by byte
+
+
+using SumKernel = uint64_t (*)(const uint8_t* _data, size_t _size);
+
+
+static uint64_t sum_scalar(const uint8_t* _data, const size_t _size)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < _size; ++i)
+    {
+        sum += _data[i];
+    }
+    return sum;
+}
+
+#if defined(__x86_64__)
+// psadbw against zero adds each group of 8 bytes into a 64-bit lane
+static uint64_t sum_sse2(const uint8_t* _data, const size_t _size)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i total = zero;
+
+    size_t i = 0;
+    for (; i + 16 <= _size; i += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(_data + i));
+        total = _mm_add_epi64(total, _mm_sad_epu8(bytes, zero));
+    }
+
+    const uint64_t sum = static_cast<uint64_t>(_mm_cvtsi128_si64(total)) + static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(total, total)));
+    return sum + sum_scalar(_data + i, _size - i);
+}
+
+__attribute__((target("avx2")))
+static uint64_t sum_avx2(const uint8_t* _data, const size_t _size)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i first = zero;
+    __m256i second = zero;
+
+    // two accumulators hide the add latency
+    size_t i = 0;
+    for (; i + 64 <= _size; i += 64)
+    {
+        const __m256i low = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_data + i));
+        const __m256i high = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_data + i + 32));
+        first = _mm256_add_epi64(first, _mm256_sad_epu8(low, zero));
+        second = _mm256_add_epi64(second, _mm256_sad_epu8(high, zero));
+    }
+    if (i + 32 <= _size)
+    {
+        const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(_data + i));
+        first = _mm256_add_epi64(first, _mm256_sad_epu8(bytes, zero));
+        i += 32;
+    }
+
+    const __m256i total = _mm256_add_epi64(first, second);
+    const __m128i half = _mm_add_epi64(_mm256_castsi256_si128(total), _mm256_extracti128_si256(total, 1));
+    const uint64_t sum = static_cast<uint64_t>(_mm_cvtsi128_si64(half)) + static_cast<uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(half, half)));
+    return sum + sum_scalar(_data + i, _size - i);
+}
+#endif // __x86_64__
+
+
+struct KernelChoice
+{
+    SumKernel sum;
+    const char* name;
+};
+
+static const KernelChoice& kernel_choice()
+{
+    // picked once, the cpu does not change
+    static const KernelChoice choice = []
+    {
+#if defined(__x86_64__)
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return KernelChoice{sum_avx2, "avx2"};
+        }
+        return KernelChoice{sum_sse2, "sse2"};
+#else
+        return KernelChoice{sum_scalar, "scalar"};
+#endif // __x86_64__
+    }();
+
+    return choice;
+}
+
+
+void Checksum::update(const uint8_t* _data, const size_t _size)
+{
+    sum += _size < CHECKSUM_SIMD_MIN_SIZE ? sum_scalar(_data, _size) : kernel_choice().sum(_data, _size);
+}
+
+uint16_t Checksum::compute(const uint8_t* _data, const size_t _size)
+{
+    Checksum checksum;
+    checksum.update(_data, _size);
+    return checksum.value();
+}
+
+const char* Checksum::kernel()
+{
+    return kernel_choice().name;
+}
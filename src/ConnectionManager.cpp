@@ -0,0 +1,874 @@
+#include "ConnectionManager.hpp"
+
+#include <algorithm>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <csignal>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/resource.h>
+
+
+#ifdef IO_URING
+enum class IoOperation : uint8_t
+{
+    CONNECT = 1,
+    RECV,
+    SEND
+};
+
+// user_data layout: session id (32 bits) | generation (24 bits) | operation (8 bits)
+static uint64_t pack_user_data(const size_t session_id, const uint32_t generation, const IoOperation operation)
+{
+    return (static_cast<uint64_t>(session_id) << 32) | ((generation & 0xFFFFFFU) << 8) | static_cast<uint8_t>(operation);
+}
+#endif // IO_URING
+
+
+ConnectionManager::ConnectionManager(std::string _host, const uint16_t _port, ProtocolFactory _factory) :
+    host(std::move(_host)),
+    port(_port),
+    factory(std::move(_factory))
+#ifdef IO_URING
+    , ring(CONNECTION_MANAGER_RING_ENTRIES)
+#endif // IO_URING
+{
+    // create wake-up event, other threads signal new work through it
+    if ((wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+    {
+        throw std::runtime_error("Eventfd creation failed: " + std::string(strerror(errno)));
+    }
+
+#ifndef IO_URING
+    // create epoll instance
+    if ((epoll_fd = epoll_create1(EPOLL_CLOEXEC)) < 0)
+    {
+        close(wake_fd);
+        throw std::runtime_error("Epoll creation failed: " + std::string(strerror(errno)));
+    }
+
+    // register wake-up event
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = CONNECTION_MANAGER_WAKE_ID;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &event) < 0)
+    {
+        const std::string error = strerror(errno);
+        close(epoll_fd);
+        close(wake_fd);
+        throw std::runtime_error("Epoll add failed: " + error);
+    }
+#else
+    // WRITE_FIXED takes no MSG_NOSIGNAL, a peer reset must not kill the process
+    signal(SIGPIPE, SIG_IGN);
+#endif // IO_URING
+
+    // raise open files limit, every session holds one fd
+    rlimit limit{};
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+ConnectionManager::~ConnectionManager()
+{
+    for (auto& session : sessions)
+    {
+        if (session.socket_fd >= 0)
+        {
+            close(session.socket_fd);
+        }
+    }
+
+#ifndef IO_URING
+    close(epoll_fd);
+#endif // IO_URING
+    close(wake_fd);
+}
+
+
+void ConnectionManager::add_sessions(const size_t count)
+{
+    if (running)
+    {
+        throw std::logic_error("Sessions must be added before run");
+    }
+
+    // check factory
+    if (!factory)
+    {
+        throw std::invalid_argument("Protocol factory must not be empty");
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        auto protocol = factory(sessions.size());
+        if (protocol != nullptr)
+        {
+            protocol->set_session_id(static_cast<uint32_t>(sessions.size()));
+        }
+
+        push_session(std::move(protocol));
+    }
+}
+
+void ConnectionManager::add_session(std::shared_ptr<AbstractProtocol> _protocol)
+{
+    const size_t index = sessions.size();
+    push_session(std::move(_protocol));
+
+    // a running loop connects at once when the ramp is done
+    if (running && next_open == index)
+    {
+        ++next_open;
+        start_session(sessions[index]);
+    }
+}
+
+void ConnectionManager::push_session(std::shared_ptr<AbstractProtocol> _protocol)
+{
+    const size_t id = sessions.size();
+
+    // check protocol
+    if (_protocol == nullptr || !_protocol->supports_events())
+    {
+        throw std::invalid_argument("Protocol of session " + std::to_string(id) + " does not support event mode");
+    }
+
+#ifdef IO_URING
+    // every session needs its buffer slots in the registered slab
+    if (!io_buffers.empty() && id >= buffer_slots)
+    {
+        throw std::length_error("Session capacity exceeded: " + std::to_string(buffer_slots));
+    }
+
+    // the ring does recv/send for the protocol
+    _protocol->set_deferred_io(true);
+#endif // IO_URING
+
+    Session& session = sessions.emplace_back();
+    session.id = id;
+    session.timer.owner = id;
+    session.protocol = std::move(_protocol);
+}
+
+void ConnectionManager::wake()
+{
+    const uint64_t value = 1;
+    if (write(wake_fd, &value, sizeof(value)) < 0 && errno != EAGAIN)
+    {
+        throw std::runtime_error("Wake-up failed: " + std::string(strerror(errno)));
+    }
+}
+
+void ConnectionManager::clear_wake()
+{
+    uint64_t value = 0;
+    while (read(wake_fd, &value, sizeof(value)) > 0) {}
+}
+
+void ConnectionManager::refresh_addresses()
+{
+    const auto now = AbstractProtocol::clock::now();
+
+    // start a lookup when the answer is old, the loop never waits for it
+    if (!pending_addresses.valid())
+    {
+        if (now < addresses_refresh)
+        {
+            return;
+        }
+        pending_addresses = Resolver::resolve_async(host, port);
+    }
+    if (pending_addresses.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        return;
+    }
+
+    try
+    {
+        addresses = pending_addresses.get();
+    }
+    catch (const std::exception& e)
+    {
+        Logger::log<LogLevel::Error>("Keeping old server addresses:", addresses.size(), e.what());
+    }
+
+    pending_addresses = {};
+    addresses_refresh = now + std::chrono::seconds(RESOLVER_TTL_S);
+}
+
+void ConnectionManager::open_session(Session& session)
+{
+    // check addresses
+    if (addresses.empty())
+    {
+        throw std::runtime_error("No server address");
+    }
+
+    const SocketAddress& address = addresses[session.address % addresses.size()];
+
+    // a range port may already reach this address, the next one is tried on a new socket
+    for (size_t retries = SourceBinding::range_ports(address.family());;)
+    {
+        // Creating non-blocking socket file descriptor
+        if ((session.socket_fd = socket(address.family(), SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP)) < 0)
+        {
+            throw std::runtime_error("Socket creation failed: " + std::string(strerror(errno)));
+        }
+
+        // protocol profile and local address, if configured
+        bool range_port = false;
+        try
+        {
+            session.protocol->socket_options().merged(socket_options).apply(session.socket_fd);
+            range_port = SourceBinding::bind(session.socket_fd, address.family());
+        }
+        catch (const std::exception&)
+        {
+            close(session.socket_fd);
+            session.socket_fd = -1;
+            throw;
+        }
+
+        // start connect, completion is reported by EPOLLOUT
+        if (connect(session.socket_fd, address.data(), address.length) == 0 || errno == EINPROGRESS)
+        {
+            break;
+        }
+
+        const int error = errno;
+        close(session.socket_fd);
+        session.socket_fd = -1;
+        if (!SourceBinding::port_busy(range_port, error) || --retries == 0)
+        {
+            throw std::runtime_error("Connect failed: " + std::string(strerror(error)));
+        }
+    } // for
+
+#ifdef IO_URING
+    // wait for connect completion
+    io_uring_sqe* sqe = ring.get_sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = session.socket_fd;
+    sqe->poll32_events = POLLOUT;
+    sqe->user_data = pack_user_data(session.id, session.generation, IoOperation::CONNECT);
+#else
+    // register socket
+    epoll_event event{};
+    event.events = EPOLLOUT;
+    event.data.u64 = session.id;
+
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, session.socket_fd, &event) < 0)
+    {
+        const std::string error = strerror(errno);
+        close(session.socket_fd);
+        session.socket_fd = -1;
+        throw std::runtime_error("Epoll add failed: " + error);
+    }
+
+    session.events = event.events;
+#endif // IO_URING
+
+    session.state = SessionState::CONNECTING;
+    ++open_sessions;
+
+    // connect deadline, the session timer is free until connected
+    timers.schedule(session.timer, to_tick(AbstractProtocol::clock::now() + std::chrono::milliseconds(CONNECTION_MANAGER_CONNECT_TIMEOUT_MS)));
+}
+
+void ConnectionManager::close_session(Session& session, const std::string& reason)
+{
+    if (session.state == SessionState::CLOSED)
+    {
+        return;
+    }
+
+    Logger::log<LogLevel::Error>("Session closed:", session.id, reason.c_str());
+
+#ifdef IO_URING
+    // complete in-flight operations, their completions are dropped by generation
+    shutdown(session.socket_fd, SHUT_RDWR);
+    ++session.generation;
+    session.recv_pending = false;
+    session.send_pending = false;
+#endif // IO_URING
+
+    // a session that never connected is already counted as a connect failure
+    if (session.state == SessionState::CONNECTED)
+    {
+        Metrics::add(Counter::CONNECTIONS_CLOSED);
+        ++counters.closes;
+    }
+
+    // epoll drops closed fds by itself
+    close(session.socket_fd);
+    session.socket_fd = -1;
+    session.state = SessionState::CLOSED;
+    timers.cancel(session.timer);
+    session.timer_deadline = {};
+    --open_sessions;
+
+    schedule_reconnect(session);
+}
+
+void ConnectionManager::start_session(Session& session)
+{
+    try
+    {
+        open_session(session);
+    }
+    catch (const std::exception& e)
+    {
+        ++counters.connect_failures;
+        ++session.address;
+        Logger::log<LogLevel::Error>("Session open failed:", session.id, e.what());
+
+        schedule_reconnect(session);
+    }
+}
+
+void ConnectionManager::schedule_reconnect(Session& session)
+{
+    if (!reconnect.enabled || !running)
+    {
+        return;
+    }
+
+    const auto now = AbstractProtocol::clock::now();
+
+    // start over after a connection that held up
+    if (session.connected_at != AbstractProtocol::clock::time_point{} && ReconnectPolicy::stable(now - session.connected_at))
+    {
+        session.attempts = 0;
+    }
+    session.connected_at = {};
+
+    if (reconnect.exhausted(session.attempts))
+    {
+        Logger::log<LogLevel::Error>("Reconnect attempts exhausted:", session.id);
+        return;
+    }
+
+    // back off, then wait for a connect token shared by all loops
+    const auto earliest = now + reconnect.delay(session.attempts++);
+    timers.schedule(session.timer, to_tick(TokenBucket::connects().reserve(earliest)));
+
+    session.reconnect_pending = true;
+    ++pending_reconnects;
+}
+
+void ConnectionManager::finish_connect(Session& session)
+{
+    // check connect result
+    int error = 0;
+    socklen_t error_len = sizeof(error);
+
+    if (getsockopt(session.socket_fd, SOL_SOCKET, SO_ERROR, &error, &error_len) < 0)
+    {
+        error = errno;
+    }
+    if (error != 0)
+    {
+        ++counters.connect_failures;
+        ++session.address;
+        throw std::runtime_error("Connect failed: " + std::string(strerror(error)));
+    }
+
+    // connected in time
+    timers.cancel(session.timer);
+
+#ifdef IO_URING
+    // the ring waits for readiness itself, O_NONBLOCK would turn it into EAGAIN
+    if (fcntl(session.socket_fd, F_SETFL, fcntl(session.socket_fd, F_GETFL) & ~O_NONBLOCK) < 0)
+    {
+        ++counters.connect_failures;
+        throw std::runtime_error("Set socket to blocking failed: " + std::string(strerror(errno)));
+    }
+#endif // IO_URING
+
+    session.state = SessionState::CONNECTED;
+    session.connected_at = AbstractProtocol::clock::now();
+    ++counters.connects;
+    Metrics::add(Counter::CONNECTIONS_OPENED);
+
+    // run protocol
+    session.protocol->on_connected(session.socket_fd);
+}
+
+void ConnectionManager::update_session(Session& session)
+{
+    const auto& protocol = session.protocol;
+
+    // check protocol state
+    if (protocol->is_closing() && !protocol->wants_write())
+    {
+        close_session(session, "closed by protocol");
+        return;
+    }
+
+#ifdef IO_URING
+    // keep a recv armed and the send buffer flowing
+    submit_io(session);
+#else
+    // update interest list
+    const uint32_t events = EPOLLIN | (protocol->wants_write() ? EPOLLOUT : 0U);
+    if (events != session.events)
+    {
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = session.id;
+
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_MOD, session.socket_fd, &event) < 0)
+        {
+            throw std::runtime_error("Epoll modify failed: " + std::string(strerror(errno)));
+        }
+
+        session.events = events;
+    }
+#endif // IO_URING
+
+    // schedule or cancel timer
+    const auto deadline = protocol->next_timer();
+    if (deadline != session.timer_deadline)
+    {
+        session.timer_deadline = deadline;
+
+        if (deadline == AbstractProtocol::clock::time_point{})
+        {
+            timers.cancel(session.timer);
+        }
+        else
+        {
+            timers.schedule(session.timer, to_tick(deadline));
+        }
+    }
+}
+
+#ifdef IO_URING
+void ConnectionManager::setup_buffers()
+{
+    // one receive and one send slot per session, sessions added later use the spare capacity
+    buffer_slots = std::max(sessions.size(), capacity);
+    io_buffers.assign(buffer_slots * 2 * CONNECTION_MANAGER_IO_BUFFER_SIZE, 0);
+
+    if (io_buffers.empty())
+    {
+        return;
+    }
+
+    // register the whole slab as one fixed buffer, fall back to plain recv/send (e.g. RLIMIT_MEMLOCK)
+    const iovec slab{io_buffers.data(), io_buffers.size()};
+    fixed_buffers = ring.register_buffers(&slab, 1);
+
+    Logger::log<LogLevel::Info>(fixed_buffers ? "io_uring fixed buffers: registered" : "io_uring fixed buffers: unavailable");
+}
+
+void ConnectionManager::arm_wake()
+{
+    io_uring_sqe* sqe = ring.get_sqe();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = wake_fd;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = CONNECTION_MANAGER_WAKE_ID;
+}
+
+void ConnectionManager::submit_io(Session& session)
+{
+    // arm receive
+    if (!session.recv_pending)
+    {
+        io_uring_sqe* sqe = ring.get_sqe();
+        sqe->opcode = fixed_buffers ? IORING_OP_READ_FIXED : IORING_OP_RECV;
+        sqe->fd = session.socket_fd;
+        sqe->addr = reinterpret_cast<uint64_t>(rx_slot(session));
+        sqe->len = CONNECTION_MANAGER_IO_BUFFER_SIZE;
+        sqe->buf_index = 0;
+        sqe->user_data = pack_user_data(session.id, session.generation, IoOperation::RECV);
+
+        session.recv_pending = true;
+    }
+
+    // send pending data, the protocol buffer may change while the send is in flight
+    if (!session.send_pending && session.protocol->wants_write())
+    {
+        const size_t size = std::min<size_t>(session.protocol->pending_size(), CONNECTION_MANAGER_IO_BUFFER_SIZE);
+        std::memcpy(tx_slot(session), session.protocol->pending_data(), size);
+
+        io_uring_sqe* sqe = ring.get_sqe();
+        sqe->opcode = fixed_buffers ? IORING_OP_WRITE_FIXED : IORING_OP_SEND;
+        sqe->fd = session.socket_fd;
+        sqe->addr = reinterpret_cast<uint64_t>(tx_slot(session));
+        sqe->len = static_cast<uint32_t>(size);
+        sqe->buf_index = 0;
+        sqe->msg_flags = fixed_buffers ? 0U : static_cast<uint32_t>(MSG_NOSIGNAL); // fixed writes rely on SIGPIPE being ignored
+        sqe->user_data = pack_user_data(session.id, session.generation, IoOperation::SEND);
+
+        session.send_pending = true;
+    }
+}
+
+void ConnectionManager::handle_completion(const io_uring_cqe& cqe)
+{
+    const size_t session_id = cqe.user_data >> 32;
+    const uint32_t generation = (cqe.user_data >> 8) & 0xFFFFFFU;
+    const auto operation = static_cast<IoOperation>(cqe.user_data & 0xFFU);
+
+    // check session
+    if (session_id >= sessions.size())
+    {
+        return;
+    }
+
+    Session& session = sessions[session_id];
+
+    // skip completions of closed sessions
+    if (session.state == SessionState::CLOSED || generation != (session.generation & 0xFFFFFFU))
+    {
+        return;
+    }
+
+    switch (operation)
+    {
+        case IoOperation::CONNECT:
+            finish_connect(session);
+            break;
+
+        case IoOperation::RECV:
+            session.recv_pending = false;
+
+            // check result
+            if (cqe.res == 0)
+            {
+                throw std::runtime_error("Connection closed by peer");
+            }
+            if (cqe.res < 0 && cqe.res != -EINTR && cqe.res != -EAGAIN)
+            {
+                throw std::runtime_error("Error receiving data: " + std::string(strerror(-cqe.res)));
+            }
+
+            if (cqe.res > 0)
+            {
+                session.protocol->on_received(rx_slot(session), cqe.res);
+            }
+            break;
+
+        case IoOperation::SEND:
+            session.send_pending = false;
+
+            // check result
+            if (cqe.res < 0 && cqe.res != -EINTR && cqe.res != -EAGAIN)
+            {
+                throw std::runtime_error("Error sending data: " + std::string(strerror(-cqe.res)));
+            }
+
+            if (cqe.res > 0)
+            {
+                session.protocol->on_sent(cqe.res);
+            }
+            break;
+    }
+
+    update_session(session);
+}
+
+void ConnectionManager::poll_events(const int wait_ms)
+{
+    // one syscall submits everything queued since the last tick and waits
+    ring.submit_and_wait(1, wait_ms);
+
+    // dispatch completions
+    io_uring_cqe cqe{};
+    while (ring.pop_completion(cqe))
+    {
+        // wake-up event, re-arm for the next one
+        if (cqe.user_data == CONNECTION_MANAGER_WAKE_ID)
+        {
+            clear_wake();
+            arm_wake();
+            continue;
+        }
+
+        const size_t session_id = cqe.user_data >> 32;
+
+        try
+        {
+            handle_completion(cqe);
+        }
+        catch (const std::exception& e)
+        {
+            close_session(sessions[session_id], e.what());
+        }
+    }
+}
+#else
+void ConnectionManager::handle_events(Session& session, const uint32_t events)
+{
+    if (session.state == SessionState::CONNECTING)
+    {
+        finish_connect(session);
+    }
+    else
+    {
+        if (events & (EPOLLIN | EPOLLHUP | EPOLLERR))
+        {
+            session.protocol->on_readable();
+        }
+        if ((events & EPOLLOUT) && session.protocol->wants_write())
+        {
+            session.protocol->on_writable();
+        }
+    }
+
+    update_session(session);
+}
+
+void ConnectionManager::poll_events(const int wait_ms)
+{
+    std::array<epoll_event, CONNECTION_MANAGER_MAX_EVENTS> events{};
+
+    const int count = epoll_wait(epoll_fd, events.data(), static_cast<int>(events.size()), wait_ms);
+
+    // check return value
+    if (count < 0)
+    {
+        if (errno == EINTR)
+        {
+            return;
+        }
+
+        throw std::runtime_error("Epoll wait failed: " + std::string(strerror(errno)));
+    }
+
+    // dispatch io events
+    for (int i = 0; i < count; ++i)
+    {
+        // wake-up event, new work is picked up by the inbox hook
+        if (events[i].data.u64 == CONNECTION_MANAGER_WAKE_ID)
+        {
+            clear_wake();
+            continue;
+        }
+
+        Session& session = sessions[events[i].data.u64];
+
+        if (session.state == SessionState::CLOSED)
+        {
+            continue;
+        }
+
+        try
+        {
+            handle_events(session, events[i].events);
+        }
+        catch (const std::exception& e)
+        {
+            close_session(session, e.what());
+        }
+    }
+}
+#endif // IO_URING
+
+void ConnectionManager::run_timers()
+{
+    const auto now = std::chrono::floor<std::chrono::milliseconds>(AbstractProtocol::clock::now() - timer_origin);
+
+    timers.advance(static_cast<uint64_t>(now.count()), [this](TimerNode& node)
+    {
+        Session& session = sessions[node.owner];
+        session.timer_deadline = {};
+
+        // backoff is over, connect again
+        if (session.reconnect_pending)
+        {
+            session.reconnect_pending = false;
+            --pending_reconnects;
+            ++counters.reconnects;
+            Metrics::add(Counter::RECONNECTS);
+
+            start_session(session);
+            return;
+        }
+
+        // connect deadline, the next attempt tries the next address
+        if (session.state == SessionState::CONNECTING)
+        {
+            ++counters.connect_failures;
+            ++session.address;
+            Metrics::add(Counter::TIMEOUTS);
+
+            close_session(session, "Connect timeout");
+            return;
+        }
+
+        try
+        {
+            session.protocol->on_timer_expired();
+            update_session(session);
+        }
+        catch (const std::exception& e)
+        {
+            close_session(session, e.what());
+        }
+    });
+}
+
+uint64_t ConnectionManager::to_tick(const AbstractProtocol::clock::time_point time_point) const
+{
+    // round up, timers never fire early
+    const auto offset = std::chrono::ceil<std::chrono::milliseconds>(time_point - timer_origin);
+
+    return static_cast<uint64_t>(std::max<int64_t>(offset.count(), 0));
+}
+
+int ConnectionManager::next_wait_ms() const
+{
+    auto deadline = AbstractProtocol::clock::time_point::max();
+
+    // earliest of timers, next ramp connect and next report
+    const uint64_t ticks = timers.next_expiry();
+    if (ticks != UINT64_MAX)
+    {
+        deadline = timer_origin + std::chrono::milliseconds(timers.now() + ticks);
+    }
+    if (next_open < sessions.size())
+    {
+        deadline = std::min(deadline, open_time(next_open));
+    }
+    if (report)
+    {
+        deadline = std::min(deadline, next_report);
+    }
+
+    if (deadline == AbstractProtocol::clock::time_point::max())
+    {
+        return CONNECTION_MANAGER_IDLE_WAIT_MS;
+    }
+
+    const auto wait = std::chrono::ceil<std::chrono::milliseconds>(deadline - AbstractProtocol::clock::now());
+
+    return static_cast<int>(std::clamp<int64_t>(wait.count(), 0, CONNECTION_MANAGER_IDLE_WAIT_MS));
+}
+
+AbstractProtocol::clock::time_point ConnectionManager::open_time(const size_t index) const
+{
+    if (!ramp)
+    {
+        return start_time;
+    }
+
+    return start_time + ramp(index, sessions.size());
+}
+
+void ConnectionManager::open_due_sessions()
+{
+    const auto now = AbstractProtocol::clock::now();
+
+    // start connecting every session whose ramp time has come
+    while (next_open < sessions.size() && open_time(next_open) <= now)
+    {
+        Session& session = sessions[next_open++];
+
+        if (session.state != SessionState::CLOSED || session.reconnect_pending)
+        {
+            continue;
+        }
+
+        start_session(session);
+    }
+}
+
+void ConnectionManager::set_report(ReportCallback _report, const AbstractProtocol::clock::duration _interval)
+{
+    if (_interval <= AbstractProtocol::clock::duration::zero())
+    {
+        throw std::invalid_argument("Report interval must be positive");
+    }
+
+    report = std::move(_report);
+    report_interval = _interval;
+}
+
+void ConnectionManager::run_report()
+{
+    if (!report || AbstractProtocol::clock::now() < next_report)
+    {
+        return;
+    }
+
+    next_report += report_interval;
+    report(counters, open_sessions);
+}
+
+void ConnectionManager::run()
+{
+    // Check is port available
+    if (port == 0)
+    {
+        throw std::runtime_error("Port is 0");
+    }
+
+#ifdef IO_URING
+    setup_buffers();
+    arm_wake();
+#endif // IO_URING
+
+    // resolve the server once, every session connects to the same addresses
+    addresses = Resolver::resolve(host, port);
+    addresses_refresh = AbstractProtocol::clock::now() + std::chrono::seconds(RESOLVER_TTL_S);
+
+    Logger::log<LogLevel::Info>("Starting sessions:", sessions.size());
+
+    // sessions without a ramp connect at once
+    start_time = AbstractProtocol::clock::now();
+    next_report = start_time + report_interval;
+    next_open = 0;
+
+    // failed first connects already go to reconnect
+    running = true;
+    open_due_sessions();
+
+    while (running && (open_sessions > 0 || pending_reconnects > 0 || next_open < sessions.size() || persistent))
+    {
+        // take sessions handed over by other threads
+        if (inbox)
+        {
+            inbox();
+        }
+
+        refresh_addresses();
+
+        // dispatch io events
+        poll_events(next_wait_ms());
+
+        // dispatch timers
+        run_timers();
+
+        // continue ramp-up
+        open_due_sessions();
+
+        run_report();
+    } // while
+
+    running = false;
+
+    // final report
+    if (report)
+    {
+        report(counters, open_sessions);
+    }
+}
+
+void ConnectionManager::stop()
+{
+    // may be called from another thread
+    running = false;
+    wake();
+}
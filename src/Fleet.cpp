@@ -0,0 +1,276 @@
+#include "Fleet.hpp"
+
+#include <sstream>
+
+#include "AS3_Protocol.hpp"
+#include "IntercomAppProtocol.hpp"
+#include "ScalesProtocol.hpp"
+#include "Metrics.hpp"
+
+
+#define INTERCOM_IMEI_DIGITS        (11U)
+
+
+Fleet::Fleet(const std::string& _host, const uint16_t _port, FleetConfig _config) :
+    config(std::move(_config))
+{
+    // check config
+    for (const auto& [protocol, weight] : config.mix)
+    {
+        total_weight += weight;
+    }
+    if (total_weight == 0)
+    {
+        throw std::invalid_argument("Fleet protocol mix is empty");
+    }
+    if (config.ramp == RampProfile::STEP && config.ramp_steps == 0)
+    {
+        throw std::invalid_argument("Ramp steps must be positive");
+    }
+
+    // spread the fleet over shards, every shard sized for its part
+    if (config.workers > 1)
+    {
+        scheduler = std::make_unique<ShardedScheduler>(_host, _port, config.workers, (config.devices + config.workers - 1) / config.workers);
+        scheduler->set_reconnect(config.reconnect);
+        scheduler->set_socket_options(config.socket_options);
+        return;
+    }
+
+    manager = std::make_unique<ConnectionManager>(_host, _port, [this](const size_t _session_id) { return create_device(_session_id); });
+    manager->add_sessions(config.devices);
+    manager->set_ramp([this](const size_t _index, const size_t _count) { return ramp_delay(_index, _count); });
+    manager->set_reconnect(config.reconnect);
+    manager->set_socket_options(config.socket_options);
+    manager->set_report([this](const ConnectionManager::Stats& _stats, const size_t _active) { print_report(_stats, _active); },
+                        std::chrono::milliseconds(FLEET_REPORT_INTERVAL_MS));
+}
+
+
+std::vector<std::pair<FleetProtocol, unsigned>> Fleet::parse_mix(const std::string& _mix)
+{
+    std::vector<std::pair<FleetProtocol, unsigned>> mix;
+
+    std::istringstream stream(_mix);
+    std::string item;
+    while (std::getline(stream, item, ','))
+    {
+        // name[:weight]
+        const size_t separator = item.find(':');
+        const std::string name = item.substr(0, separator);
+        const unsigned weight = separator == std::string::npos ? 1U : static_cast<unsigned>(std::stoul(item.substr(separator + 1)));
+
+        if (name == "as3")
+        {
+            mix.emplace_back(FleetProtocol::AS3, weight);
+        }
+        else if (name == "intercom")
+        {
+            mix.emplace_back(FleetProtocol::INTERCOM, weight);
+        }
+        else if (name == "scales")
+        {
+            mix.emplace_back(FleetProtocol::SCALES, weight);
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown fleet protocol: " + name);
+        }
+    }
+
+    return mix;
+}
+
+RampProfile Fleet::parse_ramp(const std::string& _ramp)
+{
+    if (_ramp == "linear")
+    {
+        return RampProfile::LINEAR;
+    }
+    if (_ramp == "step")
+    {
+        return RampProfile::STEP;
+    }
+    if (_ramp == "spike")
+    {
+        return RampProfile::SPIKE;
+    }
+
+    throw std::invalid_argument("Unknown ramp profile: " + _ramp);
+}
+
+
+std::shared_ptr<AbstractProtocol> Fleet::create_device(const size_t _index) const
+{
+    const uint64_t imei = config.first_imei + _index;
+
+    // interleave protocols by weight: as3:3,intercom:1 gives A A A I A A A I ...
+    unsigned slot = static_cast<unsigned>(_index % total_weight);
+    FleetProtocol protocol = config.mix.front().first;
+    for (const auto& [mix_protocol, weight] : config.mix)
+    {
+        if (slot < weight)
+        {
+            protocol = mix_protocol;
+            break;
+        }
+        slot -= weight;
+    }
+
+    switch (protocol)
+    {
+        case FleetProtocol::AS3:
+        {
+            // a journal slot per device index, the same device resumes it after a restart
+            HistoryUpload history = config.history;
+            history.slot = _index;
+            return std::make_shared<AS3_Protocol>(imei, std::move(history));
+        }
+
+        case FleetProtocol::INTERCOM:
+        {
+            // intercom imei is a fixed-width decimal string, keep the low digits
+            std::string digits = std::to_string(imei);
+            if (digits.size() > INTERCOM_IMEI_DIGITS)
+            {
+                digits.erase(0, digits.size() - INTERCOM_IMEI_DIGITS);
+            }
+            digits.insert(0, INTERCOM_IMEI_DIGITS - digits.size(), '0');
+
+            return std::make_shared<IntercomAppProtocol>(digits);
+        }
+
+        case FleetProtocol::SCALES:
+            return std::make_shared<ScalesProtocol>();
+    }
+
+    return nullptr;
+}
+
+AbstractProtocol::clock::duration Fleet::ramp_delay(const size_t _index, const size_t _count) const
+{
+    const auto ramp_time = std::chrono::duration_cast<AbstractProtocol::clock::duration>(config.ramp_time);
+    if (_count == 0 || ramp_time.count() == 0)
+    {
+        return AbstractProtocol::clock::duration::zero();
+    }
+
+    switch (config.ramp)
+    {
+        case RampProfile::LINEAR:
+            return ramp_time * _index / _count;
+
+        case RampProfile::STEP:
+        {
+            // step k of n starts at k * ramp_time / n
+            const size_t step = _index * config.ramp_steps / _count;
+            return ramp_time * step / config.ramp_steps;
+        }
+
+        case RampProfile::SPIKE:
+        {
+            const size_t base = _count * FLEET_SPIKE_BASE_PERCENT / 100;
+            if (_index < base)
+            {
+                return ramp_time * _index / base;
+            }
+            return ramp_time;
+        }
+    }
+
+    return AbstractProtocol::clock::duration::zero();
+}
+
+void Fleet::print_report(const ConnectionManager::Stats& _stats, const size_t _active)
+{
+    const size_t rate = _stats.connects - last_connects;
+    last_connects = _stats.connects;
+
+    const uint64_t history = Metrics::total(Counter::HISTORY_ACKED);
+    const uint64_t history_rate = history - last_history;
+    last_history = history;
+    if (history_rate != 0)
+    {
+        ++history_reports;
+    }
+
+    std::cout << "Fleet: active " << _active << ", connects " << _stats.connects << " (+" << rate << ")"
+              << ", failures " << _stats.connect_failures << ", closes " << _stats.closes
+              << ", reconnects " << _stats.reconnects;
+    if (history != 0)
+    {
+        std::cout << ", history " << history << " (+" << history_rate << ")";
+    }
+    std::cout << std::endl;
+
+    if (++reports % FLEET_LATENCY_REPORT_EVERY == 0)
+    {
+        LatencyRecorder::report(std::cout);
+
+        // averaged over the reports that saw acks, idle time after the flush does not count
+        if (history_reports != 0)
+        {
+            const double seconds = static_cast<double>(history_reports * FLEET_REPORT_INTERVAL_MS) / 1000;
+            std::cout << "History ingest: " << history << " acked, sustained " << static_cast<uint64_t>(history / seconds)
+                      << "/s over " << seconds << " s" << std::endl;
+        }
+    }
+}
+
+
+void Fleet::run()
+{
+    if (scheduler)
+    {
+        run_sharded();
+        return;
+    }
+
+    manager->run();
+}
+
+void Fleet::run_sharded()
+{
+    scheduler->start();
+
+    const auto start = AbstractProtocol::clock::now();
+    auto next_report = start + std::chrono::milliseconds(FLEET_REPORT_INTERVAL_MS);
+
+    // feed the ramp into the shards, report while the fleet runs
+    size_t index = 0;
+    for (;;)
+    {
+        const auto now = AbstractProtocol::clock::now();
+
+        while (index < config.devices && start + ramp_delay(index, config.devices) <= now)
+        {
+            auto device = create_device(index);
+            device->set_session_id(static_cast<uint32_t>(index));
+            scheduler->submit(std::move(device));
+            ++index;
+        }
+
+        if (now >= next_report)
+        {
+            const ShardedScheduler::Stats stats = scheduler->stats();
+            print_report({stats.connects, stats.connect_failures, stats.closes, stats.reconnects}, stats.active);
+            next_report += std::chrono::milliseconds(FLEET_REPORT_INTERVAL_MS);
+
+            // every device has been fed and closed, reconnecting fleets run until stopped
+            if (!config.reconnect.enabled && index == config.devices && stats.closes + stats.connect_failures >= config.devices)
+            {
+                break;
+            }
+        }
+
+        // sleep up to the next connect or report
+        auto wake = next_report;
+        if (index < config.devices)
+        {
+            wake = std::min(wake, start + ramp_delay(index, config.devices));
+        }
+        std::this_thread::sleep_until(wake);
+    }
+
+    scheduler->stop();
+}
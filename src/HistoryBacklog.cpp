@@ -0,0 +1,111 @@
+#include "HistoryBacklog.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include "Metrics.hpp"
+
+
+HistoryBacklog::HistoryBacklog(const size_t _record_size) :
+    record_size(_record_size),
+    capacity(0),
+    records(nullptr)
+{
+    // check record size
+    if (record_size == 0)
+    {
+        throw std::invalid_argument("History record size must be positive");
+    }
+}
+
+HistoryBacklog::HistoryBacklog(std::shared_ptr<HistoryJournal> _journal, const size_t _slot, const size_t _record_size) :
+    record_size(_record_size),
+    capacity(_journal->capacity()),
+    journal(std::move(_journal)),
+    records(journal->records(_slot)),
+    mapped(&journal->ring(_slot))
+{
+    // check record size
+    if (journal->record_size() != record_size)
+    {
+        throw std::invalid_argument("Invalid history journal record size: " + std::to_string(journal->record_size()));
+    }
+
+    // check ring, a damaged one starts over
+    if (mapped->end - mapped->first > capacity)
+    {
+        *mapped = {};
+    }
+}
+
+
+void HistoryBacklog::grow()
+{
+    const size_t count = size();
+    const size_t new_capacity = std::max<size_t>(capacity * 2, HISTORY_BACKLOG_INITIAL_RECORDS);
+
+    // unwrap into the new storage, oldest first
+    std::vector<uint8_t> new_storage(new_capacity * record_size);
+    for (size_t i = 0; i < count; ++i)
+    {
+        std::memcpy(new_storage.data() + i * record_size, record(local.first + i), record_size);
+    }
+
+    storage = std::move(new_storage);
+    records = storage.data();
+    capacity = new_capacity;
+    local = {0, count};
+}
+
+void HistoryBacklog::push(const std::span<const uint8_t> _record)
+{
+    // check record
+    if (_record.size() != record_size)
+    {
+        throw std::invalid_argument("Invalid history record size: " + std::to_string(_record.size()));
+    }
+
+    if (size() == capacity)
+    {
+        if (mapped == nullptr)
+        {
+            grow();
+        }
+        else
+        {
+            // full journal slot, the oldest record goes
+            ++mapped->first;
+            Metrics::add(Counter::HISTORY_DROPPED);
+        }
+    }
+
+    // the record first, then the end that commits it
+    HistoryRing& current = ring();
+    std::memcpy(record(current.end), _record.data(), record_size);
+    ++current.end;
+}
+
+std::span<const uint8_t> HistoryBacklog::peek(const size_t _offset, const size_t _max) const
+{
+    if (_offset >= size())
+    {
+        return {};
+    }
+
+    // contiguous up to the end of the ring
+    const uint64_t first = ring().first + _offset;
+    const size_t records_count = std::min({_max, size() - _offset, capacity - static_cast<size_t>(first % capacity)});
+    return {record(first), records_count * record_size};
+}
+
+void HistoryBacklog::pop(const size_t _count)
+{
+    // check count
+    if (_count > size())
+    {
+        throw std::out_of_range("History backlog holds fewer records: " + std::to_string(size()));
+    }
+
+    ring().first += _count;
+}
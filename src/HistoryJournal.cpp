@@ -0,0 +1,127 @@
+#include "HistoryJournal.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+static size_t align_up(const size_t _size)
+{
+    return (_size + HISTORY_JOURNAL_SLOT_ALIGN - 1) / HISTORY_JOURNAL_SLOT_ALIGN * HISTORY_JOURNAL_SLOT_ALIGN;
+}
+
+
+HistoryJournal::HistoryJournal(const std::string& _path, const size_t _slots, const size_t _capacity, const size_t _record_size)
+{
+    // check layout
+    if (_capacity == 0 || _record_size == 0)
+    {
+        throw std::invalid_argument("History journal capacity and record size must be positive");
+    }
+
+    // open or create journal file
+    if ((file_fd = ::open(_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644)) < 0)
+    {
+        throw std::runtime_error("History journal open failed: " + std::string(strerror(errno)));
+    }
+
+    try
+    {
+        // one process per journal, two writers would corrupt the rings
+        if (flock(file_fd, LOCK_EX | LOCK_NB) < 0)
+        {
+            throw std::runtime_error("History journal lock failed: " + std::string(strerror(errno)));
+        }
+
+        struct stat file_stat{};
+        if (fstat(file_fd, &file_stat) < 0)
+        {
+            throw std::runtime_error("History journal stat failed: " + std::string(strerror(errno)));
+        }
+
+        // read the header of an existing journal
+        HistoryJournalHeader file_header{};
+        const bool existing = file_stat.st_size != 0;
+        if (existing)
+        {
+            if (pread(file_fd, &file_header, sizeof(file_header), 0) != static_cast<ssize_t>(sizeof(file_header)))
+            {
+                throw std::runtime_error("History journal header is truncated");
+            }
+
+            // check header
+            if (std::memcmp(file_header.magic, HISTORY_JOURNAL_MAGIC, sizeof(file_header.magic)) != 0 || file_header.version != HISTORY_JOURNAL_VERSION)
+            {
+                throw std::runtime_error("Not a history journal: " + _path);
+            }
+            if (file_header.record_size != _record_size || file_header.capacity != _capacity)
+            {
+                throw std::runtime_error("History journal layout differs: " + std::to_string(file_header.capacity) + " records of " +
+                                         std::to_string(file_header.record_size) + " bytes");
+            }
+        }
+        else
+        {
+            std::memcpy(file_header.magic, HISTORY_JOURNAL_MAGIC, sizeof(file_header.magic));
+            file_header.version = HISTORY_JOURNAL_VERSION;
+            file_header.record_size = static_cast<uint32_t>(_record_size);
+            file_header.capacity = _capacity;
+        }
+
+        // new slots are zero, an empty ring; the file stays sparse until written
+        file_header.slots = std::max<uint64_t>(file_header.slots, _slots);
+        slot_size = align_up(sizeof(HistoryRing) + _capacity * _record_size);
+        mapped_size = align_up(sizeof(HistoryJournalHeader)) + file_header.slots * slot_size;
+
+        if (static_cast<size_t>(file_stat.st_size) < mapped_size && ftruncate(file_fd, static_cast<off_t>(mapped_size)) < 0)
+        {
+            throw std::runtime_error("History journal resize failed: " + std::string(strerror(errno)));
+        }
+
+        void* region = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, file_fd, 0);
+        if (region == MAP_FAILED)
+        {
+            throw std::runtime_error("History journal map failed: " + std::string(strerror(errno)));
+        }
+        base = static_cast<uint8_t*>(region);
+
+        // rings are read and written in place, no read-ahead of cold slots
+        madvise(base, mapped_size, MADV_RANDOM);
+        std::memcpy(base, &file_header, sizeof(file_header));
+    }
+    catch (...)
+    {
+        ::close(file_fd);
+        throw;
+    }
+}
+
+HistoryJournal::~HistoryJournal()
+{
+    // dirty pages reach the file through the page cache, also after a crash of the process
+    munmap(base, mapped_size);
+    ::close(file_fd);
+}
+
+
+HistoryRing& HistoryJournal::ring(const size_t _index) const
+{
+    // check slot
+    if (_index >= slots())
+    {
+        throw std::out_of_range("Invalid history journal slot: " + std::to_string(_index));
+    }
+
+    return *reinterpret_cast<HistoryRing*>(base + align_up(sizeof(HistoryJournalHeader)) + _index * slot_size);
+}
+
+uint8_t* HistoryJournal::records(const size_t _index) const
+{
+    return reinterpret_cast<uint8_t*>(&ring(_index)) + sizeof(HistoryRing);
+}
@@ -1,7 +1,7 @@
 #include "IntercomAppProtocol.hpp"
+#include "PacketSchema.hpp"
 
 #include <arpa/inet.h>
-#include <numeric>
 #include <unistd.h>
 
 #define HAND_SHAKE_STARTBYTE                    0XFE
@@ -23,6 +23,67 @@
 #define RESET_TEMPORARY_PIN_LIST_PACKET_SIZE    27U
 #define CHANGE_OPEN_TIME_PACKET_SIZE            20U
 
+#define PING_INTERVAL                           30U
+#define PING_JITTER_PERCENT                     10U
+#define IMEI                                    "12345678909"
+#define IMEI_SIZE                               (sizeof(IMEI) - 1)
+
+
+static constexpr PingPacket default_ping_packet
+{
+        .working_mode = 0x05,
+        .firmware_version = 0x0102,
+        .sim_info = 0x15,
+        .sim1_conn_quality = 0x0C,
+        .sim2_conn_quality = 0x0A,
+        .battery_voltage = 0xABCD,
+        .nfc_update_time = 0,
+        .pin_update_time = 0,
+        .temporary_pin_list_size = 0x0002
+};
+
+// packet layouts, see PacketSchema.hpp
+using PingSchema = WirePacket<
+    WireConst<uint8_t, PING_DATA_STARTBYTE>,
+    WireField<&PingPacket::working_mode, uint8_t>,
+    WireField<&PingPacket::firmware_version, uint16_t>,
+    WireField<&PingPacket::sim_info, uint8_t>,
+    WireField<&PingPacket::sim1_conn_quality, uint8_t>,
+    WireField<&PingPacket::sim2_conn_quality, uint8_t>,
+    WireField<&PingPacket::battery_voltage, uint16_t>,
+    WireField<&PingPacket::nfc_update_time, uint32_t>,
+    WireField<&PingPacket::pin_update_time, uint32_t>,
+    WireField<&PingPacket::temporary_pin_list_size, uint16_t>,
+    WireChecksum>;
+
+// PING_PACKET_SIZE leaves out the start byte
+static_assert(PingSchema::fixed && PingSchema::size == PING_PACKET_SIZE + 1);
+
+// the ping never changes, every device sends the same bytes
+static const WireTemplate<PingSchema> default_ping(default_ping_packet);
+
+IntercomAppProtocol::IntercomAppProtocol() :
+    imei(IMEI)
+{}
+
+IntercomAppProtocol::IntercomAppProtocol(std::string _imei) :
+    imei(std::move(_imei))
+{
+    // check imei, it has a fixed place in the handshake
+    if (imei.size() != IMEI_SIZE)
+    {
+        throw std::invalid_argument("Invalid IMEI size: " + std::to_string(imei.size()));
+    }
+}
+
+SocketOptions IntercomAppProtocol::socket_options() const
+{
+    // every write is one whole packet that waits for a 1-byte reply, there is nothing to
+    // coalesce; without nodelay a ping sent before the last segment is acked waits for it
+    SocketOptions options;
+    options.no_delay = true;
+    return options;
+}
 
 void IntercomAppProtocol::handler_loop(int _socket_fd)
 {
@@ -37,8 +98,6 @@ void IntercomAppProtocol::handler_loop(int _socket_fd)
     buffer[0] = HAND_SHAKE_STARTBYTE;
 
     // write imei
-    std::string imei = "12345678909";
-
     std::copy(imei.begin(), imei.end(), buffer.begin() + 1);
 
     // send handshake packet
@@ -49,6 +108,7 @@ void IntercomAppProtocol::handler_loop(int _socket_fd)
     catch (const std::exception& e)
     {
         std::cerr << "send error: " << e.what() << std::endl;
+        Metrics::add(Counter::HANDSHAKES_FAILED);
         return;
     }
 
@@ -60,75 +120,19 @@ void IntercomAppProtocol::handler_loop(int _socket_fd)
     catch (const std::exception& e)
     {
         std::cerr << "read error: " << e.what() << std::endl;
+        Metrics::add(Counter::HANDSHAKES_FAILED);
         return;
     }
+    Metrics::add(Counter::HANDSHAKES_OK);
 
     std::cout << "Handshake response: " << std::hex << static_cast<int>(buffer[0]) << std::endl;
 
-    // create ping struct
-    PingPacket ping_packet
-    {
-            .working_mode = 0x05,
-            .firmware_version = 0x0102,
-            .sim_info = 0x15,
-            .sim1_conn_quality = 0x0C,
-            .sim2_conn_quality = 0x0A,
-            .battery_voltage = 0xABCD,
-            .nfc_update_time = 0,
-            .pin_update_time = 0,
-            .temporary_pin_list_size = 0x0002
-    };
-
     while(1)
     {
-        // create ping packet
-        auto bufiter = buffer.begin();
-
-        // write start byte
-        *bufiter++ = PING_DATA_STARTBYTE;
-
-        // write working mode
-        *bufiter++ = ping_packet.working_mode;
-
-        // write firmware version
-        *reinterpret_cast<uint16_t*>(bufiter) = htons(ping_packet.firmware_version);
-        bufiter += sizeof(ping_packet.firmware_version);
-
-        // write sim info
-        *bufiter++ = ping_packet.sim_info;
-
-        // write sim1 conn quality
-        *bufiter++ = ping_packet.sim1_conn_quality;
-
-        // write sim2 conn quality
-        *bufiter++ = ping_packet.sim2_conn_quality;
-
-        // write battery voltage
-        *reinterpret_cast<uint16_t*>(bufiter) = htons(ping_packet.battery_voltage);
-        bufiter += sizeof(ping_packet.battery_voltage);
-
-        // write nfc update time
-        *reinterpret_cast<uint32_t*>(bufiter) = htonl(ping_packet.nfc_update_time);
-        bufiter += sizeof(ping_packet.nfc_update_time);
-
-        // write pin update time
-        *reinterpret_cast<uint32_t*>(bufiter) = htonl(ping_packet.pin_update_time);
-        bufiter += sizeof(ping_packet.pin_update_time);
-
-        // write temporary pin list size
-        *reinterpret_cast<uint16_t*>(bufiter) = htons(ping_packet.temporary_pin_list_size);
-        bufiter += sizeof(ping_packet.temporary_pin_list_size);
-
-        // calculate checksum
-        const uint16_t checksum = htons(std::accumulate(buffer.begin(), bufiter, 0));
-
-        // write checksum
-        *reinterpret_cast<uint16_t*>(bufiter) = checksum;
-
-        // send ping packet
+        // send ping packet, encoded once
         try
         {
-            send_data(buffer.data(), PING_PACKET_SIZE + 1);
+            send_data(default_ping.data(), default_ping.size());
         }
         catch (const std::exception& e)
         {
@@ -149,6 +153,58 @@ void IntercomAppProtocol::handler_loop(int _socket_fd)
 
         std::cout << "Ping response: " << std::hex << static_cast<int>(buffer[0]) << std::endl;
 
-        sleep(30);
+        sleep(PING_INTERVAL);
+    }
+}
+
+void IntercomAppProtocol::on_connected(const int _socket_fd)
+{
+    AbstractProtocol::on_connected(_socket_fd);
+
+    // create handshake packet
+    std::array<uint8_t, HAND_SHAKE_PACKET_SIZE> buffer{};
+    buffer[0] = HAND_SHAKE_STARTBYTE;
+    std::copy(imei.begin(), imei.end(), buffer.begin() + 1);
+
+    // send handshake packet
+    queue_data(buffer.data(), buffer.size());
+
+    // wait for handshake response
+    state = State::HANDSHAKE;
+    expect(1);
+}
+
+void IntercomAppProtocol::send_ping()
+{
+    queue_data(default_ping.data(), default_ping.size());
+
+    // wait for ping response
+    state = State::PING;
+    ping_sent = clock::now();
+    expect(1);
+}
+
+void IntercomAppProtocol::on_message(const uint8_t*, size_t)
+{
+    switch (state)
+    {
+        case State::HANDSHAKE:
+            Metrics::add(Counter::HANDSHAKES_OK);
+            send_ping();
+            break;
+
+        case State::PING:
+            LatencyRecorder::record(LatencyMetric::INTERCOM_PING, clock::now() - ping_sent);
+            state = State::IDLE;
+            set_timer(jittered(std::chrono::seconds(PING_INTERVAL), PING_JITTER_PERCENT));
+            break;
+
+        case State::IDLE:
+            throw std::logic_error("Unexpected message in idle state");
     }
 }
+
+void IntercomAppProtocol::on_timer()
+{
+    send_ping();
+}
@@ -0,0 +1,170 @@
+#ifdef IO_URING
+
+#include "IoUring.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <stdexcept>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+
+IoUring::IoUring(const unsigned _entries)
+{
+    io_uring_params params{};
+
+    // create ring
+    if ((ring_fd = static_cast<int>(syscall(__NR_io_uring_setup, _entries, &params))) < 0)
+    {
+        throw std::runtime_error("io_uring setup failed: " + std::string(strerror(errno)));
+    }
+
+    // check features
+    if (!(params.features & IORING_FEAT_EXT_ARG))
+    {
+        close(ring_fd);
+        throw std::runtime_error("io_uring setup failed: kernel has no IORING_FEAT_EXT_ARG");
+    }
+
+    // map submission and completion rings
+    sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+    sq_ring = mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    cq_ring = mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_CQ_RING);
+    void* sqes_map = mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+
+    if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes_map == MAP_FAILED)
+    {
+        const std::string error = strerror(errno);
+        if (sq_ring != MAP_FAILED) munmap(sq_ring, sq_ring_size);
+        if (cq_ring != MAP_FAILED) munmap(cq_ring, cq_ring_size);
+        if (sqes_map != MAP_FAILED) munmap(sqes_map, sqes_size);
+        close(ring_fd);
+        throw std::runtime_error("io_uring mmap failed: " + error);
+    }
+
+    auto* sq = static_cast<uint8_t*>(sq_ring);
+    sq_head = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+    sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sq_entries = params.sq_entries;
+    sqes = static_cast<io_uring_sqe*>(sqes_map);
+    sq_local_tail = *sq_tail;
+
+    auto* cq = static_cast<uint8_t*>(cq_ring);
+    cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+}
+
+IoUring::~IoUring()
+{
+    munmap(sqes, sqes_size);
+    munmap(cq_ring, cq_ring_size);
+    munmap(sq_ring, sq_ring_size);
+    close(ring_fd);
+}
+
+
+int IoUring::enter(const unsigned submit, const unsigned wait_nr, const int timeout_ms)
+{
+    unsigned flags = wait_nr > 0 ? IORING_ENTER_GETEVENTS : 0U;
+
+    // wait with timeout
+    __kernel_timespec timeout{timeout_ms / 1000, (timeout_ms % 1000) * 1000000LL};
+    io_uring_getevents_arg arg{};
+    arg.ts = reinterpret_cast<uint64_t>(&timeout);
+
+    if (wait_nr > 0 && timeout_ms >= 0)
+    {
+        flags |= IORING_ENTER_EXT_ARG;
+        return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, submit, wait_nr, flags, &arg, sizeof(arg)));
+    }
+
+    return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, submit, wait_nr, flags, nullptr, 0));
+}
+
+io_uring_sqe* IoUring::get_sqe()
+{
+    // flush a full submission queue
+    if (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries)
+    {
+        submit_and_wait(0, 0);
+
+        if (sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE) >= sq_entries)
+        {
+            throw std::runtime_error("io_uring submission queue is full");
+        }
+    }
+
+    const unsigned index = sq_local_tail & *sq_mask;
+    io_uring_sqe* sqe = &sqes[index];
+    std::memset(sqe, 0, sizeof(*sqe));
+
+    // publish entry
+    sq_array[index] = index;
+    ++sq_local_tail;
+    __atomic_store_n(sq_tail, sq_local_tail, __ATOMIC_RELEASE);
+    ++to_submit;
+
+    return sqe;
+}
+
+unsigned IoUring::submit_and_wait(const unsigned wait_nr, const int timeout_ms)
+{
+    for (;;)
+    {
+        const int result = enter(to_submit, wait_nr, timeout_ms);
+
+        // the kernel moves sq head past every consumed entry
+        to_submit = sq_local_tail - __atomic_load_n(sq_head, __ATOMIC_ACQUIRE);
+
+        if (result >= 0)
+        {
+            return result;
+        }
+
+        // check return value
+        switch (errno)
+        {
+            case EINTR:
+                continue;
+
+            case ETIME:
+            case EAGAIN:
+            case EBUSY:
+                return 0;
+
+            default:
+                throw std::runtime_error("io_uring enter failed: " + std::string(strerror(errno)));
+        }
+    }
+}
+
+bool IoUring::pop_completion(io_uring_cqe& cqe)
+{
+    const unsigned head = *cq_head;
+
+    if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+    {
+        return false;
+    }
+
+    cqe = cqes[head & *cq_mask];
+    __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+
+    return true;
+}
+
+bool IoUring::register_buffers(const iovec* buffers, const unsigned count)
+{
+    return syscall(__NR_io_uring_register, ring_fd, IORING_REGISTER_BUFFERS, buffers, count) == 0;
+}
+
+#endif // IO_URING
@@ -9,6 +9,16 @@
 #define COMMAND_GET_LIST        "LST"
 #define COMMAND_SEND_DATA       "SND"
 
+#define DEVICE_IMEI             (1234567890ULL)
+
+
+LV_Protocol::LV_Protocol() :
+    imei(DEVICE_IMEI)
+{}
+
+LV_Protocol::LV_Protocol(const uint64_t _imei) :
+    imei(_imei)
+{}
 
 void LV_Protocol::handler_loop(const int _socket_fd)
 {
@@ -47,6 +57,7 @@ void LV_Protocol::handler_loop(const int _socket_fd)
             {
                 // Send command
                 std::copy_n(COMMAND_GET_LIST, COMMAND_SIZE, buffer.begin());
+                const auto list_sent = clock::now();
                 try
                 {
                     send_data(buffer.data(), COMMAND_SIZE);
@@ -90,25 +101,17 @@ void LV_Protocol::handler_loop(const int _socket_fd)
                         std::cout << "Device: " << be64toh(*reinterpret_cast<uint64_t*>(buffer.data() + i * sizeof(uint64_t))) << std::endl;
                     }
                 }
+                LatencyRecorder::record(LatencyMetric::LV_LIST, clock::now() - list_sent);
 
                 break;
             }
             case 2:
             {
-                // Send command
-                std::copy_n(COMMAND_SEND_DATA, COMMAND_SIZE, buffer.begin());
-                try
-                {
-                    send_data(buffer.data(), COMMAND_SIZE);
-                }
-                catch (const std::exception& e)
-                {
-                    throw std::runtime_error(std::format("Error sending packet: {}", e.what()));
-                }
+                // queue command, it goes out together with the data
+                defer_send(COMMAND_SEND_DATA, COMMAND_SIZE);
 
                 // Write IMEI
                 std::uintptr_t bufiter = 0;
-                constexpr uint64_t imei = 1234567890;
                 *reinterpret_cast<uint64_t*>(buffer.data()) = htobe64(imei);
                 bufiter += sizeof(uint64_t);
 
@@ -0,0 +1,172 @@
+#include "LatencyRecorder.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+
+#define LATENCY_MAX_VALUE               ((1ULL << LATENCY_MAX_VALUE_BITS) - 1)
+#define LATENCY_HALF_SUB_BUCKETS        (LATENCY_SUB_BUCKETS / 2)
+
+
+size_t LatencyHistogram::index_of(uint64_t _value)
+{
+    _value = std::min<uint64_t>(_value, LATENCY_MAX_VALUE);
+
+    // bucket 0 is linear, every next bucket doubles the sub-bucket width
+    const unsigned width = std::bit_width(_value);
+    const unsigned bucket = width > LATENCY_SUB_BUCKET_BITS ? width - LATENCY_SUB_BUCKET_BITS : 0;
+    return bucket * LATENCY_HALF_SUB_BUCKETS + (_value >> bucket);
+}
+
+uint64_t LatencyHistogram::value_of(const size_t _index)
+{
+    if (_index < LATENCY_SUB_BUCKETS)
+    {
+        return _index;
+    }
+
+    const size_t bucket = _index / LATENCY_HALF_SUB_BUCKETS - 1;
+    const uint64_t sub_bucket = _index - bucket * LATENCY_HALF_SUB_BUCKETS;
+    return ((sub_bucket + 1) << bucket) - 1;
+}
+
+
+void LatencyHistogram::record(const uint64_t _value)
+{
+    // one writer per histogram, no read-modify-write needed
+    auto& count = counts[index_of(_value)];
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    if (_value > max_value.load(std::memory_order_relaxed))
+    {
+        max_value.store(_value, std::memory_order_relaxed);
+    }
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& _other)
+{
+    for (size_t i = 0; i < LATENCY_COUNTS; ++i)
+    {
+        const uint64_t count = _other.counts[i].load(std::memory_order_relaxed);
+        if (count != 0)
+        {
+            counts[i].fetch_add(count, std::memory_order_relaxed);
+        }
+    }
+
+    const uint64_t other_max = _other.max();
+    if (other_max > max())
+    {
+        max_value.store(other_max, std::memory_order_relaxed);
+    }
+}
+
+uint64_t LatencyHistogram::total() const
+{
+    uint64_t total = 0;
+    for (const auto& count : counts)
+    {
+        total += count.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint64_t LatencyHistogram::percentile(const double _percentile) const
+{
+    const uint64_t total_count = total();
+    if (total_count == 0)
+    {
+        return 0;
+    }
+
+    const auto target = std::max<uint64_t>(static_cast<uint64_t>(std::ceil(static_cast<double>(total_count) * _percentile / 100.0)), 1);
+
+    uint64_t seen = 0;
+    for (size_t i = 0; i < LATENCY_COUNTS; ++i)
+    {
+        seen += counts[i].load(std::memory_order_relaxed);
+        if (seen >= target)
+        {
+            return std::min(value_of(i), max());
+        }
+    }
+
+    return max();
+}
+
+
+LatencyRecorder& LatencyRecorder::instance()
+{
+    static LatencyRecorder recorder;
+    return recorder;
+}
+
+LatencyRecorder::ThreadHistograms& LatencyRecorder::thread_histograms()
+{
+    // registered once per thread, reports merge all of them
+    thread_local std::shared_ptr<ThreadHistograms> thread_histograms = []
+    {
+        auto new_histograms = std::make_shared<ThreadHistograms>();
+        LatencyRecorder& recorder = instance();
+        std::lock_guard<std::mutex> lock(recorder.histograms_mutex);
+        recorder.histograms.push_back(new_histograms);
+        return new_histograms;
+    }();
+
+    return *thread_histograms;
+}
+
+const char* LatencyRecorder::metric_name(const LatencyMetric _metric)
+{
+    switch (_metric)
+    {
+        case LatencyMetric::AS3_PING:      return "AS3 ping";
+        case LatencyMetric::AS3_HISTORY:   return "AS3 history";
+        case LatencyMetric::LV_LIST:       return "LV list";
+        case LatencyMetric::INTERCOM_PING: return "Intercom ping";
+        default:                           return "unknown";
+    }
+}
+
+
+void LatencyRecorder::record(const LatencyMetric _metric, const std::chrono::steady_clock::duration _latency)
+{
+    const auto microseconds = std::chrono::duration_cast<std::chrono::microseconds>(_latency).count();
+    thread_histograms()[static_cast<size_t>(_metric)].record(static_cast<uint64_t>(std::max<int64_t>(microseconds, 0)));
+}
+
+void LatencyRecorder::report(std::ostream& _stream)
+{
+    LatencyRecorder& recorder = instance();
+
+    // merge outside the hot path, the writers keep going meanwhile
+    auto merged = std::make_unique<ThreadHistograms>();
+    {
+        std::lock_guard<std::mutex> lock(recorder.histograms_mutex);
+        for (const auto& thread : recorder.histograms)
+        {
+            for (size_t i = 0; i < merged->size(); ++i)
+            {
+                (*merged)[i].merge((*thread)[i]);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < merged->size(); ++i)
+    {
+        const LatencyHistogram& histogram = (*merged)[i];
+        const uint64_t count = histogram.total();
+        if (count == 0)
+        {
+            continue;
+        }
+
+        _stream << "Latency " << metric_name(static_cast<LatencyMetric>(i)) << " (us): count " << count
+                << ", p50 " << histogram.percentile(50.0)
+                << ", p90 " << histogram.percentile(90.0)
+                << ", p99 " << histogram.percentile(99.0)
+                << ", p99.9 " << histogram.percentile(99.9)
+                << ", max " << histogram.max() << std::endl;
+    }
+}
@@ -0,0 +1,233 @@
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <unistd.h>
+
+
+#define LOGGER_OUTPUT_RESERVE           (64U * 1024U)
+
+
+// "00 " .. "ff " for every byte value
+static constexpr std::array<char, 256 * 3> HEX_TABLE = []
+{
+    constexpr char digits[] = "0123456789abcdef";
+    std::array<char, 256 * 3> table{};
+    for (size_t i = 0; i < 256; ++i)
+    {
+        table[i * 3] = digits[i >> 4];
+        table[i * 3 + 1] = digits[i & 0x0F];
+        table[i * 3 + 2] = ' ';
+    }
+    return table;
+}();
+
+
+Logger::Logger()
+{
+    output.reserve(LOGGER_OUTPUT_RESERVE);
+
+    running = true;
+    writer = std::thread(&Logger::writer_loop, this);
+}
+
+Logger::~Logger()
+{
+    running = false;
+    if (writer.joinable())
+    {
+        writer.join();
+    }
+
+    // write what is left
+    drain();
+}
+
+
+Logger& Logger::instance()
+{
+    static Logger logger;
+    return logger;
+}
+
+Logger::ThreadRing& Logger::thread_ring()
+{
+    // registered once per thread, the logger keeps it until drained
+    thread_local std::shared_ptr<ThreadRing> ring = []
+    {
+        auto new_ring = std::make_shared<ThreadRing>();
+        Logger& logger = instance();
+        std::lock_guard<std::mutex> lock(logger.rings_mutex);
+        logger.rings.push_back(new_ring);
+        return new_ring;
+    }();
+
+    return *ring;
+}
+
+void Logger::push(const LogLevel _level, const char* _message, const RecordKind _kind, const uint64_t _value, const uint8_t* _data, const size_t _size)
+{
+    ThreadRing& ring = thread_ring();
+
+    // check free space, drop the record when the writer is behind
+    const size_t tail = ring.tail.load(std::memory_order_relaxed);
+    if (tail - ring.head.load(std::memory_order_acquire) >= LOGGER_RING_CAPACITY)
+    {
+        ring.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // fill record in place
+    Record& record = ring.records[tail & (LOGGER_RING_CAPACITY - 1)];
+    record.level = _level;
+    record.kind = _kind;
+    record.message = _message;
+    record.value = _value;
+    record.payload_size = static_cast<uint16_t>(std::min<size_t>(_size, LOGGER_RECORD_PAYLOAD));
+    if (_data != nullptr && record.payload_size > 0)
+    {
+        std::memcpy(record.payload.data(), _data, record.payload_size);
+    }
+
+    // publish
+    ring.tail.store(tail + 1, std::memory_order_release);
+}
+
+void Logger::flush()
+{
+    instance().drain();
+}
+
+
+void Logger::writer_loop()
+{
+    while (running.load(std::memory_order_relaxed))
+    {
+        // sleep only when there was nothing to write
+        if (drain() == 0)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(LOGGER_FLUSH_INTERVAL_MS));
+        }
+    }
+}
+
+size_t Logger::drain()
+{
+    std::lock_guard<std::mutex> drain_lock(drain_mutex);
+
+    std::vector<std::shared_ptr<ThreadRing>> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(rings_mutex);
+        snapshot = rings;
+    }
+
+    size_t count = 0;
+    output.clear();
+
+    for (const auto& ring : snapshot)
+    {
+        // format everything published so far
+        size_t head = ring->head.load(std::memory_order_relaxed);
+        const size_t tail = ring->tail.load(std::memory_order_acquire);
+        for (; head != tail; ++head)
+        {
+            format(ring->records[head & (LOGGER_RING_CAPACITY - 1)]);
+            ++count;
+        }
+        ring->head.store(head, std::memory_order_release);
+
+        // report lost records
+        const uint64_t dropped = ring->dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0)
+        {
+            format({LogLevel::Error, RecordKind::VALUE, 0, "Log records dropped:", dropped, {}});
+        }
+    }
+
+    // one write for the whole batch
+    size_t written = 0;
+    while (written < output.size())
+    {
+        const ssize_t result = write(STDOUT_FILENO, output.data() + written, output.size() - written);
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            break;
+        }
+        written += result;
+    }
+
+    return count;
+}
+
+void Logger::format(const Record& record)
+{
+    switch (record.level)
+    {
+        case LogLevel::Error:
+            output += "[E] ";
+            break;
+        case LogLevel::Info:
+            output += "[I] ";
+            break;
+        case LogLevel::Debug:
+            output += "[D] ";
+            break;
+    }
+
+    output += record.message;
+
+    switch (record.kind)
+    {
+        case RecordKind::TEXT:
+            break;
+
+        case RecordKind::VALUE:
+        {
+            char number[24];
+            const auto result = std::to_chars(number, number + sizeof(number), record.value);
+            output += ' ';
+            output.append(number, result.ptr);
+
+            // optional copied text
+            if (record.payload_size > 0)
+            {
+                output += ": ";
+                output.append(reinterpret_cast<const char*>(record.payload.data()), record.payload_size);
+            }
+            break;
+        }
+
+        case RecordKind::HEX:
+        {
+            output += ' ';
+
+            // table lookup, three chars per byte
+            const size_t start = output.size();
+            output.resize(start + record.payload_size * 3);
+            for (size_t i = 0; i < record.payload_size; ++i)
+            {
+                std::memcpy(&output[start + i * 3], &HEX_TABLE[record.payload[i] * 3], 3);
+            }
+
+            // mark truncated data
+            if (record.value > record.payload_size)
+            {
+                char number[24];
+                const auto result = std::to_chars(number, number + sizeof(number), record.value);
+                output += "... (";
+                output.append(number, result.ptr);
+                output += " bytes)";
+            }
+            break;
+        }
+    }
+
+    output += '\n';
+}
@@ -0,0 +1,295 @@
+#include "Metrics.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+
+#define METRICS_PREFIX                  "tcp_client_"
+#define METRICS_REQUEST_MAX_SIZE        (4096U)
+#define METRICS_REQUEST_TIMEOUT_S       (1U)
+
+
+// indexed by ProtocolId
+static constexpr std::array<const char*, METRICS_PROTOCOLS> PROTOCOL_NAMES
+{
+    "unknown", "test", "intercom", "scales", "as3", "lv", "ba5", "other"
+};
+
+
+Metrics::~Metrics()
+{
+    running = false;
+    if (listen_fd >= 0)
+    {
+        shutdown(listen_fd, SHUT_RDWR);
+    }
+    if (server.joinable())
+    {
+        server.join();
+    }
+    if (listen_fd >= 0)
+    {
+        ::close(listen_fd);
+    }
+}
+
+
+Metrics& Metrics::instance()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::ThreadCounters& Metrics::thread_counters()
+{
+    // registered once per thread, scrapes sum all of them
+    thread_local std::shared_ptr<ThreadCounters> thread_counters = []
+    {
+        auto new_counters = std::make_shared<ThreadCounters>();
+        Metrics& metrics = instance();
+        std::lock_guard<std::mutex> lock(metrics.counters_mutex);
+        metrics.counters.push_back(new_counters);
+        return new_counters;
+    }();
+
+    return *thread_counters;
+}
+
+void Metrics::increment(std::atomic<uint64_t>& _counter, const uint64_t _value)
+{
+    // only the owning thread writes, no read-modify-write needed
+    _counter.store(_counter.load(std::memory_order_relaxed) + _value, std::memory_order_relaxed);
+}
+
+
+void Metrics::add(const Counter _counter, const uint64_t _value)
+{
+    increment(thread_counters().counters[static_cast<size_t>(_counter)], _value);
+}
+
+uint64_t Metrics::total(const Counter _counter)
+{
+    Metrics& metrics = instance();
+    uint64_t sum = 0;
+
+    std::lock_guard<std::mutex> lock(metrics.counters_mutex);
+    for (const auto& thread : metrics.counters)
+    {
+        sum += thread->counters[static_cast<size_t>(_counter)].load(std::memory_order_relaxed);
+    }
+    return sum;
+}
+
+void Metrics::add_frame(const uint16_t _protocol_id, const CaptureDirection _direction, const size_t _size)
+{
+    ThreadCounters& thread = thread_counters();
+
+    const size_t protocol = std::min<size_t>(_protocol_id, METRICS_PROTOCOLS - 1);
+    increment(thread.frames[protocol][static_cast<size_t>(_direction)], 1);
+    increment(thread.counters[static_cast<size_t>(_direction == CaptureDirection::SENT ? Counter::BYTES_SENT : Counter::BYTES_RECEIVED)], _size);
+}
+
+
+void Metrics::serve(const uint16_t _port)
+{
+    Metrics& metrics = instance();
+
+    // check state
+    if (metrics.listen_fd >= 0)
+    {
+        throw std::logic_error("Metrics listener is already running");
+    }
+
+    const int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+    {
+        throw std::runtime_error("Metrics socket failed: " + std::string(strerror(errno)));
+    }
+
+    const int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(_port);
+    inet_pton(AF_INET, METRICS_LISTEN_ADDRESS, &address.sin_addr);
+
+    if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0 || listen(fd, METRICS_LISTEN_BACKLOG) < 0)
+    {
+        const std::string error = strerror(errno);
+        ::close(fd);
+        throw std::runtime_error("Metrics listen failed: " + error);
+    }
+
+    metrics.listen_fd = fd;
+    metrics.running = true;
+    metrics.server = std::thread(&Metrics::serve_loop, &metrics);
+}
+
+void Metrics::close()
+{
+    Metrics& metrics = instance();
+
+    metrics.running = false;
+    if (metrics.listen_fd < 0)
+    {
+        return;
+    }
+
+    // wakes the blocked accept()
+    shutdown(metrics.listen_fd, SHUT_RDWR);
+    if (metrics.server.joinable())
+    {
+        metrics.server.join();
+    }
+
+    ::close(metrics.listen_fd);
+    metrics.listen_fd = -1;
+}
+
+
+void Metrics::serve_loop()
+{
+    std::array<char, METRICS_REQUEST_MAX_SIZE> request{};
+
+    while (running)
+    {
+        const int client_fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client_fd < 0)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            break;
+        }
+
+        // a silent client must not block the next scrape
+        const timeval timeout{METRICS_REQUEST_TIMEOUT_S, 0};
+        setsockopt(client_fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        setsockopt(client_fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+        // the request line is enough, headers and body are ignored
+        const ssize_t size = recv(client_fd, request.data(), request.size(), 0);
+        const std::string_view request_line(request.data(), size > 0 ? static_cast<size_t>(size) : 0);
+
+        std::string response;
+        if (request_line.starts_with("GET /metrics ") || request_line.starts_with("GET / "))
+        {
+            const std::string body = render();
+            response = "HTTP/1.0 200 OK\r\n"
+                       "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+                       "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                       "Connection: close\r\n\r\n" + body;
+        }
+        else
+        {
+            response = "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+        }
+
+        // send all, give up on errors
+        size_t sent = 0;
+        while (sent < response.size())
+        {
+            const ssize_t result = send(client_fd, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+            if (result <= 0)
+            {
+                break;
+            }
+            sent += result;
+        }
+
+        ::close(client_fd);
+    } // while
+}
+
+std::string Metrics::render()
+{
+    std::array<uint64_t, static_cast<size_t>(Counter::COUNT)> totals{};
+    std::array<std::array<uint64_t, 2>, METRICS_PROTOCOLS> frames{};
+
+    // sum the thread blocks, writers keep going meanwhile
+    {
+        std::lock_guard<std::mutex> lock(counters_mutex);
+        for (const auto& thread : counters)
+        {
+            for (size_t i = 0; i < totals.size(); ++i)
+            {
+                totals[i] += thread->counters[i].load(std::memory_order_relaxed);
+            }
+            for (size_t i = 0; i < METRICS_PROTOCOLS; ++i)
+            {
+                frames[i][0] += thread->frames[i][0].load(std::memory_order_relaxed);
+                frames[i][1] += thread->frames[i][1].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    const auto total = [&totals](const Counter _counter) { return std::to_string(totals[static_cast<size_t>(_counter)]); };
+
+    // opened and closed are summed from different threads, the gauge must not wrap
+    const uint64_t opened = totals[static_cast<size_t>(Counter::CONNECTIONS_OPENED)];
+    const uint64_t closed = totals[static_cast<size_t>(Counter::CONNECTIONS_CLOSED)];
+
+    std::string text;
+    text += "# HELP " METRICS_PREFIX "connections_open Connections currently established.\n"
+            "# TYPE " METRICS_PREFIX "connections_open gauge\n"
+            METRICS_PREFIX "connections_open " + std::to_string(opened > closed ? opened - closed : 0) + "\n";
+
+    text += "# HELP " METRICS_PREFIX "connections_total Connections established since start.\n"
+            "# TYPE " METRICS_PREFIX "connections_total counter\n"
+            METRICS_PREFIX "connections_total " + std::to_string(opened) + "\n";
+
+    text += "# HELP " METRICS_PREFIX "handshakes_total Protocol handshakes by result.\n"
+            "# TYPE " METRICS_PREFIX "handshakes_total counter\n"
+            METRICS_PREFIX "handshakes_total{result=\"ok\"} " + total(Counter::HANDSHAKES_OK) + "\n"
+            METRICS_PREFIX "handshakes_total{result=\"failed\"} " + total(Counter::HANDSHAKES_FAILED) + "\n";
+
+    text += "# HELP " METRICS_PREFIX "bytes_total Payload bytes by direction.\n"
+            "# TYPE " METRICS_PREFIX "bytes_total counter\n"
+            METRICS_PREFIX "bytes_total{direction=\"sent\"} " + total(Counter::BYTES_SENT) + "\n"
+            METRICS_PREFIX "bytes_total{direction=\"received\"} " + total(Counter::BYTES_RECEIVED) + "\n";
+
+    text += "# HELP " METRICS_PREFIX "frames_total Frames by protocol and direction.\n"
+            "# TYPE " METRICS_PREFIX "frames_total counter\n";
+    for (size_t i = 0; i < METRICS_PROTOCOLS; ++i)
+    {
+        // skip protocols that never ran
+        if (frames[i][0] == 0 && frames[i][1] == 0)
+        {
+            continue;
+        }
+
+        const std::string labels = METRICS_PREFIX "frames_total{protocol=\"" + std::string(PROTOCOL_NAMES[i]) + "\",direction=";
+        text += labels + "\"sent\"} " + std::to_string(frames[i][static_cast<size_t>(CaptureDirection::SENT)]) + "\n";
+        text += labels + "\"received\"} " + std::to_string(frames[i][static_cast<size_t>(CaptureDirection::RECEIVED)]) + "\n";
+    }
+
+    text += "# HELP " METRICS_PREFIX "crc_failures_total Device config packets with a bad crc.\n"
+            "# TYPE " METRICS_PREFIX "crc_failures_total counter\n"
+            METRICS_PREFIX "crc_failures_total " + total(Counter::CRC_FAILURES) + "\n";
+
+    text += "# HELP " METRICS_PREFIX "timeouts_total Socket send and receive timeouts.\n"
+            "# TYPE " METRICS_PREFIX "timeouts_total counter\n"
+            METRICS_PREFIX "timeouts_total " + total(Counter::TIMEOUTS) + "\n";
+
+    text += "# HELP " METRICS_PREFIX "reconnects_total Reconnect attempts.\n"
+            "# TYPE " METRICS_PREFIX "reconnects_total counter\n"
+            METRICS_PREFIX "reconnects_total " + total(Counter::RECONNECTS) + "\n";
+
+    text += "# HELP " METRICS_PREFIX "history_acked_total History records acknowledged by the server.\n"
+            "# TYPE " METRICS_PREFIX "history_acked_total counter\n"
+            METRICS_PREFIX "history_acked_total " + total(Counter::HISTORY_ACKED) + "\n";
+
+    text += "# HELP " METRICS_PREFIX "history_dropped_total History records overwritten in a full journal slot.\n"
+            "# TYPE " METRICS_PREFIX "history_dropped_total counter\n"
+            METRICS_PREFIX "history_dropped_total " + total(Counter::HISTORY_DROPPED) + "\n";
+
+    return text;
+}
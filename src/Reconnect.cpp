@@ -0,0 +1,70 @@
+#include "Reconnect.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <stdexcept>
+
+
+std::chrono::steady_clock::duration ReconnectPolicy::delay(const unsigned _attempt) const
+{
+    thread_local std::minstd_rand generator{std::random_device{}()};
+
+    const std::chrono::steady_clock::duration base_delay = base;
+    const std::chrono::steady_clock::duration cap_delay = cap;
+
+    // base * 2^attempt without overflow
+    auto ceiling = cap_delay;
+    if (_attempt < 62 && base_delay.count() <= (cap_delay.count() >> _attempt))
+    {
+        ceiling = base_delay * (int64_t{1} << _attempt);
+    }
+    if (ceiling.count() <= 0)
+    {
+        return std::chrono::steady_clock::duration::zero();
+    }
+
+    // full jitter
+    std::uniform_int_distribution<std::chrono::steady_clock::rep> distribution(0, ceiling.count());
+    return std::chrono::steady_clock::duration(distribution(generator));
+}
+
+
+TokenBucket& TokenBucket::connects()
+{
+    static TokenBucket bucket;
+    return bucket;
+}
+
+void TokenBucket::configure(const double _rate, const unsigned _burst)
+{
+    if (_rate < 0.0)
+    {
+        throw std::invalid_argument("Token rate must not be negative");
+    }
+
+    interval_ns = _rate > 0.0 ? static_cast<int64_t>(std::llround(1e9 / _rate)) : 0;
+    burst_ns = interval_ns * std::max(_burst, 1U);
+}
+
+std::chrono::steady_clock::time_point TokenBucket::reserve(const std::chrono::steady_clock::time_point _earliest)
+{
+    if (interval_ns == 0)
+    {
+        return _earliest;
+    }
+
+    const int64_t earliest = std::chrono::duration_cast<std::chrono::nanoseconds>(_earliest.time_since_epoch()).count();
+
+    // a full bucket lets burst tokens through at once, then one per interval
+    int64_t arrival = arrival_ns.load(std::memory_order_relaxed);
+    for (;;)
+    {
+        const int64_t start = std::max(arrival, earliest);
+        if (arrival_ns.compare_exchange_weak(arrival, start + interval_ns, std::memory_order_relaxed))
+        {
+            const int64_t ready = std::max(earliest, start - (burst_ns - interval_ns));
+            return std::chrono::steady_clock::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::nanoseconds(ready)));
+        }
+    }
+}
@@ -0,0 +1,303 @@
+#include "ReplayProtocol.hpp"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+
+ReplayProtocol::ReplayProtocol(ReplayTrace _trace, const double _speed) :
+    trace(std::move(_trace)),
+    speed(_speed)
+{
+    // check speed
+    if (speed < 0)
+    {
+        throw std::invalid_argument("Replay speed must not be negative");
+    }
+}
+
+
+ReplayTrace ReplayProtocol::load(const std::string& _path, const uint32_t _session_id)
+{
+    // detect binary capture by magic
+    std::ifstream file(_path, std::ios::binary);
+    if (!file)
+    {
+        throw std::runtime_error("Replay file open failed: " + _path);
+    }
+
+    char magic[sizeof(CaptureFileHeader::magic)]{};
+    file.read(magic, sizeof(magic));
+
+    if (file.gcount() == sizeof(magic) && std::memcmp(magic, CAPTURE_MAGIC, sizeof(magic)) == 0)
+    {
+        return load_capture(_path, _session_id);
+    }
+
+    return load_hex_dump(_path);
+}
+
+ReplayTrace ReplayProtocol::load_capture(const std::string& _path, const uint32_t _session_id)
+{
+    const int file_fd = open(_path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file_fd < 0)
+    {
+        throw std::runtime_error("Capture file open failed: " + std::string(strerror(errno)));
+    }
+
+    struct stat file_stat{};
+    if (fstat(file_fd, &file_stat) < 0)
+    {
+        const std::string error = strerror(errno);
+        close(file_fd);
+        throw std::runtime_error("Capture file stat failed: " + error);
+    }
+
+    const auto file_size = static_cast<size_t>(file_stat.st_size);
+    if (file_size < sizeof(CaptureFileHeader))
+    {
+        close(file_fd);
+        throw std::runtime_error("Capture file too small");
+    }
+
+    void* region = mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, file_fd, 0);
+    close(file_fd);
+    if (region == MAP_FAILED)
+    {
+        throw std::runtime_error("Capture file map failed: " + std::string(strerror(errno)));
+    }
+    const auto* data = static_cast<const uint8_t*>(region);
+
+    // check file header
+    CaptureFileHeader header{};
+    std::memcpy(&header, data, sizeof(header));
+    if (header.version != CAPTURE_VERSION || header.record_header_size != sizeof(CaptureRecordHeader))
+    {
+        munmap(region, file_size);
+        throw std::runtime_error("Unsupported capture version: " + std::to_string(header.version));
+    }
+
+    ReplayTrace trace;
+    uint32_t session_id = _session_id;
+    uint64_t first_timestamp = 0;
+
+    size_t offset = sizeof(CaptureFileHeader);
+    while (offset + sizeof(CaptureRecordHeader) <= file_size)
+    {
+        CaptureRecordHeader record{};
+        std::memcpy(&record, data + offset, sizeof(record));
+
+        // a zero size marks the unwritten tail
+        if (record.size == 0 || offset + sizeof(record) + record.size > file_size)
+        {
+            break;
+        }
+
+        // take the first session when none is given
+        if (session_id == UINT32_MAX)
+        {
+            session_id = record.session_id;
+        }
+
+        if (record.session_id == session_id)
+        {
+            if (trace.frames.empty())
+            {
+                first_timestamp = record.timestamp_ns;
+                trace.protocol = static_cast<ProtocolId>(record.protocol_id);
+            }
+
+            const uint8_t* payload = data + offset + sizeof(record);
+            trace.frames.push_back({
+                record.timestamp_ns - first_timestamp,
+                static_cast<CaptureDirection>(record.direction),
+                std::vector<uint8_t>(payload, payload + record.size)
+            });
+        }
+
+        offset += sizeof(record) + ((record.size + CAPTURE_RECORD_ALIGN - 1) & ~(CAPTURE_RECORD_ALIGN - 1));
+    }
+
+    munmap(region, file_size);
+
+    return trace;
+}
+
+// "[D] Sending bytes: 15" or "Sending 15 bytes data ..." (older logs)
+static bool parse_direction(const std::string& _line, CaptureDirection& _direction, size_t& _size)
+{
+    size_t position = _line.find("Sending ");
+    _direction = CaptureDirection::SENT;
+    if (position == std::string::npos)
+    {
+        position = _line.find("Reading ");
+        _direction = CaptureDirection::RECEIVED;
+    }
+    if (position == std::string::npos)
+    {
+        return false;
+    }
+
+    // the size follows, an error message about sending does not match
+    const char* rest = _line.c_str() + position + 8;
+    if (std::strncmp(rest, "bytes:", 6) == 0)
+    {
+        rest += 6;
+    }
+    char* end = nullptr;
+    _size = std::strtoul(rest, &end, 10);
+    return end != rest;
+}
+
+ReplayTrace ReplayProtocol::load_hex_dump(const std::string& _path)
+{
+    std::ifstream file(_path);
+    if (!file)
+    {
+        throw std::runtime_error("Hex dump open failed: " + _path);
+    }
+
+    ReplayTrace trace;
+    ReplayFrame frame{};
+    size_t expected = 0;    // frame size from the direction line
+    bool open = false;
+
+    // a direction line opens a frame of n bytes, the "Data:" lines after it fill it
+    // (a scatter-gather send logs one line per part); the log has no timing
+    std::string line;
+    while (std::getline(file, line))
+    {
+        CaptureDirection direction{};
+        size_t size = 0;
+        if (parse_direction(line, direction, size))
+        {
+            // a frame without data is a failed read or send, a partial one is an error
+            if (open && !frame.data.empty())
+            {
+                throw std::runtime_error("Hex dump frame is incomplete: " + std::to_string(frame.data.size()) + " of " + std::to_string(expected) + " bytes");
+            }
+
+            frame = {0, direction, {}};
+            expected = size;
+            open = true;
+            continue;
+        }
+
+        const size_t position = line.find("Data:");
+        if (position == std::string::npos)
+        {
+            continue;
+        }
+
+        // check direction
+        if (!open)
+        {
+            throw std::runtime_error("Hex dump frame without direction: " + line);
+        }
+
+        // the logger keeps LOGGER_RECORD_PAYLOAD bytes of each part
+        const size_t cut = line.find("...", position);
+        if (cut != std::string::npos)
+        {
+            throw std::runtime_error("Hex dump is truncated, replay a capture file (-c) instead: " + line.substr(cut));
+        }
+
+        // parse hex bytes
+        std::istringstream bytes(line.substr(position + 5));
+        std::string byte;
+        while (bytes >> byte)
+        {
+            frame.data.push_back(static_cast<uint8_t>(std::stoul(byte, nullptr, 16)));
+        }
+
+        if (frame.data.size() > expected)
+        {
+            throw std::runtime_error("Hex dump frame is longer than announced: " + std::to_string(frame.data.size()) + " > " + std::to_string(expected));
+        }
+        if (frame.data.size() < expected)
+        {
+            continue;
+        }
+
+        if (!frame.data.empty())
+        {
+            trace.frames.push_back(std::move(frame));
+        }
+        open = false;
+    }
+
+    // check last frame
+    if (open && !frame.data.empty())
+    {
+        throw std::runtime_error("Hex dump frame is incomplete: " + std::to_string(frame.data.size()) + " of " + std::to_string(expected) + " bytes");
+    }
+
+    return trace;
+}
+
+
+void ReplayProtocol::handler_loop(const int _socket_fd)
+{
+    // set socket fd
+    socket_fd = _socket_fd;
+
+    size_t sent = 0;
+    size_t received = 0;
+    size_t mismatched = 0;
+
+    const auto start = clock::now();
+
+    for (size_t i = 0; i < trace.frames.size(); ++i)
+    {
+        const ReplayFrame& frame = trace.frames[i];
+
+        if (frame.direction == CaptureDirection::SENT)
+        {
+            // keep the recorded spacing
+            if (speed > 0)
+            {
+                std::this_thread::sleep_until(start + std::chrono::nanoseconds(static_cast<int64_t>(static_cast<double>(frame.offset_ns) / speed)));
+            }
+
+            try
+            {
+                send_data(frame.data.data(), frame.data.size());
+            }
+            catch (const std::exception& e)
+            {
+                std::cerr << "Error sending frame " << i << ": " << e.what() << std::endl;
+                break;
+            }
+            ++sent;
+            continue;
+        }
+
+        // read the same amount and compare with the recording
+        try
+        {
+            const std::span<const uint8_t> reply = recv_view(frame.data.size());
+            if (std::memcmp(reply.data(), frame.data.data(), reply.size()) != 0)
+            {
+                Logger::log<LogLevel::Error>("Replay frame mismatch:", i);
+                ++mismatched;
+            }
+            consume(reply.size());
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "Error reading frame " << i << ": " << e.what() << std::endl;
+            break;
+        }
+        ++received;
+    }
+
+    std::cout << "Replay: sent " << sent << ", received " << received << ", mismatched " << mismatched
+              << " of " << trace.frames.size() << " frames" << std::endl;
+}
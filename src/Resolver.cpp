@@ -0,0 +1,209 @@
+#include "Resolver.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+
+
+std::string SocketAddress::to_string() const
+{
+    char text[INET6_ADDRSTRLEN]{};
+
+    if (family() == AF_INET6)
+    {
+        const auto* address = reinterpret_cast<const sockaddr_in6*>(&storage);
+        inet_ntop(AF_INET6, &address->sin6_addr, text, sizeof(text));
+        return "[" + std::string(text) + "]:" + std::to_string(ntohs(address->sin6_port));
+    }
+
+    const auto* address = reinterpret_cast<const sockaddr_in*>(&storage);
+    inet_ntop(AF_INET, &address->sin_addr, text, sizeof(text));
+    return std::string(text) + ":" + std::to_string(ntohs(address->sin_port));
+}
+
+
+uint16_t SocketAddress::port() const
+{
+    if (family() == AF_INET6)
+    {
+        return ntohs(reinterpret_cast<const sockaddr_in6*>(&storage)->sin6_port);
+    }
+    return ntohs(reinterpret_cast<const sockaddr_in*>(&storage)->sin_port);
+}
+
+void SocketAddress::set_port(const uint16_t _port)
+{
+    if (family() == AF_INET6)
+    {
+        reinterpret_cast<sockaddr_in6*>(&storage)->sin6_port = htons(_port);
+        return;
+    }
+    reinterpret_cast<sockaddr_in*>(&storage)->sin_port = htons(_port);
+}
+
+
+// "[::1]" -> "::1"
+static std::string strip_brackets(const std::string& _host)
+{
+    if (_host.size() > 2 && _host.front() == '[' && _host.back() == ']')
+    {
+        return _host.substr(1, _host.size() - 2);
+    }
+    return _host;
+}
+
+
+Resolver& Resolver::instance()
+{
+    static Resolver resolver;
+    return resolver;
+}
+
+AddressList Resolver::lookup(const std::string& _host, const uint16_t _port, const int _family)
+{
+    addrinfo hints{};
+    hints.ai_family = _family;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+    hints.ai_flags = AI_ADDRCONFIG | AI_NUMERICSERV;
+
+    addrinfo* result = nullptr;
+    const int error = getaddrinfo(strip_brackets(_host).c_str(), std::to_string(_port).c_str(), &hints, &result);
+    if (error != 0)
+    {
+        throw std::runtime_error("Resolve failed: " + _host + ": " + gai_strerror(error));
+    }
+
+    // split by family, getaddrinfo already sorted them by preference
+    AddressList first;
+    AddressList second;
+    for (const addrinfo* info = result; info != nullptr; info = info->ai_next)
+    {
+        if (info->ai_addrlen > sizeof(sockaddr_storage))
+        {
+            continue;
+        }
+
+        SocketAddress address;
+        std::memcpy(&address.storage, info->ai_addr, info->ai_addrlen);
+        address.length = info->ai_addrlen;
+
+        if (first.empty() || first.front().family() == address.family())
+        {
+            first.push_back(address);
+        }
+        else
+        {
+            second.push_back(address);
+        }
+    }
+    freeaddrinfo(result);
+
+    // interleave the families, the preferred one first
+    AddressList addresses;
+    addresses.reserve(first.size() + second.size());
+    for (size_t i = 0; i < std::max(first.size(), second.size()); ++i)
+    {
+        if (i < first.size())
+        {
+            addresses.push_back(first[i]);
+        }
+        if (i < second.size())
+        {
+            addresses.push_back(second[i]);
+        }
+    }
+
+    if (addresses.empty())
+    {
+        throw std::runtime_error("Resolve failed: " + _host + ": no addresses");
+    }
+
+    return addresses;
+}
+
+
+void Resolver::set_family(const int _family)
+{
+    if (_family != AF_UNSPEC && _family != AF_INET && _family != AF_INET6)
+    {
+        throw std::invalid_argument("Invalid address family: " + std::to_string(_family));
+    }
+
+    instance().family = _family;
+}
+
+SocketAddress Resolver::parse_numeric(const std::string& _address, const uint16_t _port)
+{
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+
+    addrinfo* result = nullptr;
+    const int error = getaddrinfo(strip_brackets(_address).c_str(), std::to_string(_port).c_str(), &hints, &result);
+    if (error != 0)
+    {
+        throw std::invalid_argument("Invalid address: " + _address + ": " + gai_strerror(error));
+    }
+
+    SocketAddress address;
+    std::memcpy(&address.storage, result->ai_addr, std::min<size_t>(result->ai_addrlen, sizeof(sockaddr_storage)));
+    address.length = result->ai_addrlen;
+    freeaddrinfo(result);
+
+    return address;
+}
+
+std::shared_future<AddressList> Resolver::resolve_async(const std::string& _host, const uint16_t _port)
+{
+    Resolver& resolver = instance();
+    const auto now = std::chrono::steady_clock::now();
+    const int family = resolver.family.load(std::memory_order_relaxed);
+    const std::string key = _host + ":" + std::to_string(_port) + "/" + std::to_string(family);
+
+    std::lock_guard<std::mutex> lock(resolver.cache_mutex);
+
+    // reuse a lookup in flight or an answer within its ttl
+    const auto found = resolver.cache.find(key);
+    if (found != resolver.cache.end())
+    {
+        const Entry& entry = found->second;
+        if (entry.addresses.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return entry.addresses;
+        }
+
+        // a failed lookup is retried sooner
+        auto ttl = std::chrono::seconds(RESOLVER_TTL_S);
+        try
+        {
+            entry.addresses.get();
+        }
+        catch (const std::exception&)
+        {
+            ttl = std::chrono::seconds(RESOLVER_FAILURE_TTL_S);
+        }
+
+        if (now < entry.started + ttl)
+        {
+            return entry.addresses;
+        }
+    }
+
+    // the lookup thread gets its own copy of the host
+    Entry entry;
+    entry.addresses = std::async(std::launch::async, &Resolver::lookup, _host, _port, family).share();
+    entry.started = now;
+    resolver.cache[key] = entry;
+
+    return entry.addresses;
+}
+
+AddressList Resolver::resolve(const std::string& _host, const uint16_t _port)
+{
+    return resolve_async(_host, _port).get();
+}
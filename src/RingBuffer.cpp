@@ -0,0 +1,158 @@
+#include "RingBuffer.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+
+
+RingBuffer::~RingBuffer()
+{
+    unmap(base, ring_capacity);
+}
+
+
+uint8_t* RingBuffer::map(const size_t _capacity)
+{
+    // create backing memory
+    const int memory_fd = memfd_create("ring_buffer", MFD_CLOEXEC);
+    if (memory_fd < 0)
+    {
+        throw std::runtime_error("Ring buffer memfd failed: " + std::string(strerror(errno)));
+    }
+
+    if (ftruncate(memory_fd, static_cast<off_t>(_capacity)) < 0)
+    {
+        const std::string error = strerror(errno);
+        close(memory_fd);
+        throw std::runtime_error("Ring buffer resize failed: " + error);
+    }
+
+    // reserve address space for two views
+    void* region = mmap(nullptr, 2 * _capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED)
+    {
+        const std::string error = strerror(errno);
+        close(memory_fd);
+        throw std::runtime_error("Ring buffer reserve failed: " + error);
+    }
+
+    // map the same memory twice back to back
+    auto* view = static_cast<uint8_t*>(region);
+    if (mmap(view, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memory_fd, 0) == MAP_FAILED ||
+        mmap(view + _capacity, _capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, memory_fd, 0) == MAP_FAILED)
+    {
+        const std::string error = strerror(errno);
+        munmap(region, 2 * _capacity);
+        close(memory_fd);
+        throw std::runtime_error("Ring buffer mirror failed: " + error);
+    }
+
+    // the mappings keep the memory alive
+    close(memory_fd);
+
+    return view;
+}
+
+void RingBuffer::unmap(uint8_t* _base, const size_t _capacity)
+{
+    if (_base != nullptr)
+    {
+        munmap(_base, 2 * _capacity);
+    }
+}
+
+void RingBuffer::clear()
+{
+    head = 0;
+    tail = 0;
+}
+
+void RingBuffer::reserve(const size_t _size)
+{
+    if (_size <= capacity())
+    {
+        return;
+    }
+    if (_size > RING_BUFFER_MAX_CAPACITY)
+    {
+        throw std::out_of_range("Frame too big: " + std::to_string(_size));
+    }
+
+    // grow to a power of two of whole pages (mapped lazily on first use)
+    const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    const size_t new_capacity = std::bit_ceil(std::max({_size, page_size, static_cast<size_t>(RING_BUFFER_DEFAULT_CAPACITY)}));
+
+    uint8_t* new_base = map(new_capacity);
+
+    // move the content to the new ring
+    const size_t used = size();
+    if (used > 0)
+    {
+        copy_out(new_base, used);
+    }
+
+    unmap(base, ring_capacity);
+    base = new_base;
+    ring_capacity = new_capacity;
+    head = 0;
+    tail = used;
+}
+
+void RingBuffer::append(const uint8_t* data, const size_t _size)
+{
+    reserve(size() + _size);
+
+    std::memcpy(base + (tail & mask()), data, _size);
+    tail += _size;
+}
+
+void RingBuffer::consume(const size_t _size)
+{
+    if (_size > size())
+    {
+        throw std::out_of_range("Consume size too big: " + std::to_string(_size));
+    }
+
+    head += _size;
+}
+
+void RingBuffer::copy_out(uint8_t* data, const size_t _size) const
+{
+    const auto frame = peek(_size);
+    std::memcpy(data, frame.data(), frame.size());
+}
+
+std::span<const uint8_t> RingBuffer::peek(const size_t _size) const
+{
+    if (_size > size())
+    {
+        throw std::out_of_range("Peek size too big: " + std::to_string(_size));
+    }
+
+    // the mirror makes every frame contiguous
+    return {base + (head & mask()), _size};
+}
+
+ssize_t RingBuffer::fill(const int socket_fd, const int flags)
+{
+    // a zero-length recv would look like a closed connection
+    if (free_space() == 0)
+    {
+        throw std::logic_error("Receive buffer full");
+    }
+
+    // the free space is contiguous in the mirror
+    const ssize_t result = recv(socket_fd, base + (tail & mask()), free_space(), flags);
+    if (result > 0)
+    {
+        tail += result;
+    }
+
+    return result;
+}
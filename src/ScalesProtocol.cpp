@@ -3,18 +3,44 @@
 #include <string>
 #include <unistd.h>
 
+#define WEIGHT_PACKET_SIZE      (8U)
+#define WEIGHT_INTERVAL         (30U)
+#define WEIGHT_JITTER_PERCENT   (10U)
+
+static constexpr std::array<uint8_t, WEIGHT_PACKET_SIZE> weight_packet{0x3d, 0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x2d};
+
 void ScalesProtocol::handler_loop(const int _socket_fd)
 {
     // set socket fd
     socket_fd = _socket_fd;
 
-    std::array<uint8_t, 128> buffer{0x3d, 0x31, 0x30, 0x30, 0x30, 0x30, 0x30, 0x2d};
+    std::array<uint8_t, 128> buffer{};
+    std::copy(weight_packet.begin(), weight_packet.end(), buffer.begin());
 
     while (true)
     {
-        send_data(buffer.data(), 8);
+        send_data(buffer.data(), WEIGHT_PACKET_SIZE);
         std::cout << "ScalesProtocol::handler_loop()" << std::endl;
 
-        sleep(30);
+        sleep(WEIGHT_INTERVAL);
     }
-}
\ No newline at end of file
+}
+
+void ScalesProtocol::on_connected(const int _socket_fd)
+{
+    AbstractProtocol::on_connected(_socket_fd);
+
+    on_timer();
+}
+
+void ScalesProtocol::on_data()
+{
+    // server responses are not used
+    rx_buffer.clear();
+}
+
+void ScalesProtocol::on_timer()
+{
+    queue_data(weight_packet.data(), weight_packet.size());
+    set_timer(jittered(std::chrono::seconds(WEIGHT_INTERVAL), WEIGHT_JITTER_PERCENT));
+}
@@ -0,0 +1,169 @@
+#include "ShardedScheduler.hpp"
+
+#include <cstring>
+#include <pthread.h>
+#include <sched.h>
+
+
+ShardedScheduler::ShardedScheduler(const std::string& _host, const uint16_t _port, const size_t _workers, const size_t _capacity)
+{
+    // check workers
+    if (_workers == 0)
+    {
+        throw std::invalid_argument("Scheduler needs at least one worker");
+    }
+
+    shards.reserve(_workers);
+    for (size_t i = 0; i < _workers; ++i)
+    {
+        auto shard = std::make_unique<Shard>();
+        Shard& shard_ref = *shard;
+        shard->index = i;
+
+        // sessions come only through the queue
+        shard->manager = std::make_unique<ConnectionManager>(_host, _port, nullptr);
+        shard->manager->set_persistent(true);
+        shard->manager->set_capacity(_capacity);
+        shard->manager->set_inbox([this, &shard_ref] { drain_queue(shard_ref); });
+
+        // publish counters for stats()
+        shard->manager->set_report([&shard_ref](const ConnectionManager::Stats& _stats, const size_t _active)
+        {
+            shard_ref.connects.store(_stats.connects, std::memory_order_relaxed);
+            shard_ref.connect_failures.store(_stats.connect_failures, std::memory_order_relaxed);
+            shard_ref.closes.store(_stats.closes, std::memory_order_relaxed);
+            shard_ref.reconnects.store(_stats.reconnects, std::memory_order_relaxed);
+            shard_ref.active.store(_active, std::memory_order_relaxed);
+        }, std::chrono::milliseconds(SCHEDULER_STATS_INTERVAL_MS));
+
+        shards.push_back(std::move(shard));
+    }
+}
+
+ShardedScheduler::~ShardedScheduler()
+{
+    stop();
+}
+
+
+void ShardedScheduler::pin_thread(std::thread& _thread, const size_t _core)
+{
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET(_core, &cpu_set);
+
+    // pinning is best effort (containers may restrict the cpu set)
+    const int result = pthread_setaffinity_np(_thread.native_handle(), sizeof(cpu_set), &cpu_set);
+    if (result != 0)
+    {
+        Logger::log<LogLevel::Error>("Worker pinning failed, core:", _core, strerror(result));
+    }
+}
+
+void ShardedScheduler::drain_queue(Shard& _shard) const
+{
+    // stop on the worker thread, a stop before run() would be lost otherwise
+    if (stopping.load(std::memory_order_relaxed))
+    {
+        _shard.manager->stop();
+        return;
+    }
+
+    std::shared_ptr<AbstractProtocol> protocol;
+    while (_shard.queue.try_pop(protocol))
+    {
+        try
+        {
+            _shard.manager->add_session(std::move(protocol));
+        }
+        catch (const std::exception& e)
+        {
+            Logger::log<LogLevel::Error>("Session handover failed, shard:", _shard.index, e.what());
+        }
+    }
+}
+
+
+void ShardedScheduler::submit(std::shared_ptr<AbstractProtocol> _protocol)
+{
+    Shard& shard = *shards[next_shard];
+    next_shard = (next_shard + 1) % shards.size();
+
+    // back off while the worker catches up
+    while (!shard.queue.try_push(std::move(_protocol)))
+    {
+        shard.manager->wake();
+        std::this_thread::yield();
+    }
+
+    shard.manager->wake();
+}
+
+void ShardedScheduler::set_reconnect(const ReconnectPolicy& _reconnect)
+{
+    for (auto& shard : shards)
+    {
+        shard->manager->set_reconnect(_reconnect);
+    }
+}
+
+void ShardedScheduler::set_socket_options(const SocketOptions& _socket_options)
+{
+    for (auto& shard : shards)
+    {
+        shard->manager->set_socket_options(_socket_options);
+    }
+}
+
+void ShardedScheduler::start()
+{
+    const unsigned cores = std::max(std::thread::hardware_concurrency(), 1U);
+
+    for (size_t i = 0; i < shards.size(); ++i)
+    {
+        Shard& shard = *shards[i];
+        shard.thread = std::thread([&shard]
+        {
+            try
+            {
+                shard.manager->run();
+            }
+            catch (const std::exception& e)
+            {
+                Logger::log<LogLevel::Error>("Worker stopped, shard:", shard.index, e.what());
+            }
+        });
+
+        pin_thread(shard.thread, i % cores);
+    }
+}
+
+void ShardedScheduler::stop()
+{
+    stopping = true;
+
+    for (auto& shard : shards)
+    {
+        if (shard->thread.joinable())
+        {
+            shard->manager->wake();
+            shard->thread.join();
+        }
+    }
+}
+
+ShardedScheduler::Stats ShardedScheduler::stats() const
+{
+    Stats total;
+
+    for (const auto& shard : shards)
+    {
+        total.connects += shard->connects.load(std::memory_order_relaxed);
+        total.connect_failures += shard->connect_failures.load(std::memory_order_relaxed);
+        total.closes += shard->closes.load(std::memory_order_relaxed);
+        total.reconnects += shard->reconnects.load(std::memory_order_relaxed);
+        total.active += shard->active.load(std::memory_order_relaxed);
+    }
+
+    return total;
+}
@@ -0,0 +1,153 @@
+#include "SocketOptions.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+
+SocketOptions SocketOptions::merged(const SocketOptions& _overrides) const
+{
+    SocketOptions result = *this;
+
+    const auto take = [](auto& _target, const auto& _source)
+    {
+        if (_source)
+        {
+            _target = _source;
+        }
+    };
+
+    take(result.no_delay, _overrides.no_delay);
+    take(result.quick_ack, _overrides.quick_ack);
+    take(result.send_buffer, _overrides.send_buffer);
+    take(result.receive_buffer, _overrides.receive_buffer);
+    take(result.keepalive_idle_s, _overrides.keepalive_idle_s);
+    take(result.keepalive_interval_s, _overrides.keepalive_interval_s);
+    take(result.keepalive_count, _overrides.keepalive_count);
+    take(result.busy_poll_us, _overrides.busy_poll_us);
+    take(result.user_timeout_ms, _overrides.user_timeout_ms);
+
+    return result;
+}
+
+
+void SocketOptions::apply(const int _socket_fd) const
+{
+    const auto set = [_socket_fd](const int _level, const int _name, const char* _label, const int _value)
+    {
+        if (setsockopt(_socket_fd, _level, _name, &_value, sizeof(_value)) < 0)
+        {
+            throw std::runtime_error("Set " + std::string(_label) + " failed: " + std::string(strerror(errno)));
+        }
+    };
+
+    if (no_delay)
+    {
+        set(IPPROTO_TCP, TCP_NODELAY, "TCP_NODELAY", *no_delay);
+    }
+    if (quick_ack)
+    {
+        set(IPPROTO_TCP, TCP_QUICKACK, "TCP_QUICKACK", *quick_ack);
+    }
+    if (send_buffer)
+    {
+        set(SOL_SOCKET, SO_SNDBUF, "SO_SNDBUF", *send_buffer);
+    }
+    if (receive_buffer)
+    {
+        set(SOL_SOCKET, SO_RCVBUF, "SO_RCVBUF", *receive_buffer);
+    }
+    if (keepalive_idle_s)
+    {
+        set(SOL_SOCKET, SO_KEEPALIVE, "SO_KEEPALIVE", *keepalive_idle_s > 0);
+        if (*keepalive_idle_s > 0)
+        {
+            set(IPPROTO_TCP, TCP_KEEPIDLE, "TCP_KEEPIDLE", *keepalive_idle_s);
+        }
+    }
+    if (keepalive_interval_s)
+    {
+        set(IPPROTO_TCP, TCP_KEEPINTVL, "TCP_KEEPINTVL", *keepalive_interval_s);
+    }
+    if (keepalive_count)
+    {
+        set(IPPROTO_TCP, TCP_KEEPCNT, "TCP_KEEPCNT", *keepalive_count);
+    }
+    if (busy_poll_us)
+    {
+        set(SOL_SOCKET, SO_BUSY_POLL, "SO_BUSY_POLL", *busy_poll_us);
+    }
+    if (user_timeout_ms)
+    {
+        set(IPPROTO_TCP, TCP_USER_TIMEOUT, "TCP_USER_TIMEOUT", static_cast<int>(*user_timeout_ms));
+    }
+}
+
+
+SocketOptions SocketOptions::parse(const std::string& _text)
+{
+    SocketOptions options;
+
+    size_t start = 0;
+    while (start < _text.size())
+    {
+        const size_t end = std::min(_text.find(',', start), _text.size());
+        const std::string item = _text.substr(start, end - start);
+        start = end + 1;
+
+        // "name" alone switches a flag on
+        const size_t separator = item.find('=');
+        const std::string name = item.substr(0, separator);
+        const std::string value = separator == std::string::npos ? "1" : item.substr(separator + 1);
+
+        if (name == "nodelay")
+        {
+            options.no_delay = std::stoi(value) != 0;
+        }
+        else if (name == "quickack")
+        {
+            options.quick_ack = std::stoi(value) != 0;
+        }
+        else if (name == "sndbuf")
+        {
+            options.send_buffer = std::stoi(value);
+        }
+        else if (name == "rcvbuf")
+        {
+            options.receive_buffer = std::stoi(value);
+        }
+        else if (name == "keepalive")
+        {
+            // idle[:interval[:count]], 0 - off
+            const size_t first = value.find(':');
+            options.keepalive_idle_s = std::stoi(value.substr(0, first));
+            if (first != std::string::npos)
+            {
+                const size_t second = value.find(':', first + 1);
+                options.keepalive_interval_s = std::stoi(value.substr(first + 1, second - first - 1));
+                if (second != std::string::npos)
+                {
+                    options.keepalive_count = std::stoi(value.substr(second + 1));
+                }
+            }
+        }
+        else if (name == "busypoll")
+        {
+            options.busy_poll_us = std::stoi(value);
+        }
+        else if (name == "usertimeout")
+        {
+            options.user_timeout_ms = static_cast<unsigned>(std::stoul(value));
+        }
+        else
+        {
+            throw std::invalid_argument("Unknown socket option: " + name);
+        }
+    } // while
+
+    return options;
+}
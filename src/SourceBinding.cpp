@@ -0,0 +1,168 @@
+#include "SourceBinding.hpp"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+
+SourceBinding& SourceBinding::instance()
+{
+    static SourceBinding binding;
+    return binding;
+}
+
+
+void SourceBinding::add(const std::string& _sources)
+{
+    SourceBinding& binding = instance();
+
+    size_t start = 0;
+    while (start <= _sources.size())
+    {
+        const size_t end = std::min(_sources.find(',', start), _sources.size());
+        const std::string text = _sources.substr(start, end - start);
+        start = end + 1;
+
+        // split "address[:first[-last]]", a bare IPv6 address has several colons
+        std::string host = text;
+        std::string ports;
+        if (!text.empty() && text.front() == '[')
+        {
+            const size_t bracket = text.find(']');
+            if (bracket == std::string::npos || (bracket + 1 < text.size() && text[bracket + 1] != ':'))
+            {
+                throw std::invalid_argument("Invalid source address: " + text);
+            }
+            host = text.substr(0, bracket + 1);
+            ports = bracket + 1 < text.size() ? text.substr(bracket + 2) : "";
+        }
+        else if (text.find(':') != std::string::npos && text.find(':') == text.rfind(':'))
+        {
+            const size_t separator = text.find(':');
+            host = text.substr(0, separator);
+            ports = text.substr(separator + 1);
+        }
+
+        // validate everything before the source joins the pool
+        const SocketAddress address = Resolver::parse_numeric(host, 0);
+        unsigned long first = 0;
+        unsigned long last = 0;
+
+        if (!ports.empty())
+        {
+            const size_t separator = ports.find('-');
+            try
+            {
+                first = std::stoul(ports.substr(0, separator));
+                last = separator == std::string::npos ? first : std::stoul(ports.substr(separator + 1));
+            }
+            catch (const std::logic_error&)
+            {
+                first = 0;
+            }
+            if (first == 0 || last < first || last > UINT16_MAX)
+            {
+                throw std::invalid_argument("Invalid source port range: " + ports);
+            }
+        }
+
+        Source& source = binding.sources.emplace_back();
+        source.address = address;
+        source.first_port = static_cast<uint16_t>(first);
+        source.last_port = static_cast<uint16_t>(last);
+    } // while
+}
+
+
+bool SourceBinding::bind_source(Source& _source, const int _socket_fd)
+{
+    SocketAddress local = _source.address;
+    const int enable = 1;
+
+    // any port, chosen by connect() against the full 4-tuple
+    if (_source.first_port == 0)
+    {
+        if (setsockopt(_socket_fd, IPPROTO_IP, IP_BIND_ADDRESS_NO_PORT, &enable, sizeof(enable)) < 0 ||
+            ::bind(_socket_fd, local.data(), local.length) < 0)
+        {
+            throw std::runtime_error("Source bind failed: " + std::string(strerror(errno)));
+        }
+        return true;
+    }
+
+    // a port may be shared with connections to other destinations
+    if (setsockopt(_socket_fd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable)) < 0)
+    {
+        throw std::runtime_error("Source bind failed: " + std::string(strerror(errno)));
+    }
+
+    // walk the range once, starting where the last connection left off
+    const uint32_t count = _source.last_port - _source.first_port + 1U;
+    const uint32_t start = _source.next_port.fetch_add(1, std::memory_order_relaxed);
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        local.set_port(static_cast<uint16_t>(_source.first_port + (start + i) % count));
+        if (::bind(_socket_fd, local.data(), local.length) == 0)
+        {
+            return true;
+        }
+        if (errno != EADDRINUSE)
+        {
+            throw std::runtime_error("Source bind failed: " + std::string(strerror(errno)));
+        }
+    }
+
+    return false;
+}
+
+bool SourceBinding::bind(const int _socket_fd, const int _family)
+{
+    SourceBinding& binding = instance();
+
+    // check state
+    const size_t count = binding.sources.size();
+    if (count == 0)
+    {
+        return false;
+    }
+
+    // round robin over the sources of this family, an exhausted range passes to the next
+    const uint32_t start = binding.next_source.fetch_add(1, std::memory_order_relaxed);
+    bool matched = false;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Source& source = binding.sources[(start + i) % count];
+        if (source.address.family() != _family)
+        {
+            continue;
+        }
+
+        matched = true;
+        if (bind_source(source, _socket_fd))
+        {
+            return source.first_port != 0;
+        }
+    }
+
+    if (matched)
+    {
+        throw std::runtime_error("Source bind failed: all source ports in use");
+    }
+    return false;
+}
+
+size_t SourceBinding::range_ports(const int _family)
+{
+    size_t ports = 0;
+    for (const Source& source : instance().sources)
+    {
+        if (source.address.family() == _family && source.first_port != 0)
+        {
+            ports += source.last_port - source.first_port + 1U;
+        }
+    }
+    return ports;
+}
@@ -4,13 +4,15 @@
 #include <netdb.h>
 #include <cstring>
 #include <fcntl.h>
+#include <poll.h>
+#include <thread>
 #include <unistd.h>
 
 
-TCP_Client::TCP_Client(const std::string& _ip, const uint16_t _port, std::shared_ptr<AbstractProtocol> _protocol) :
-    ip(inet_addr(_ip.c_str())),
-    port(_port),
-    protocol(std::move(_protocol))
+TCP_Client::TCP_Client(std::string _host, const uint16_t _port, std::shared_ptr<AbstractProtocol> _protocol) :
+    protocol(std::move(_protocol)),
+    host(std::move(_host)),
+    port(_port)
 {}
 
 TCP_Client::~TCP_Client()
@@ -19,105 +21,339 @@ TCP_Client::~TCP_Client()
 }
 
 
-void TCP_Client::create_socket()
+int TCP_Client::create_socket(const int _family, bool& _range_port) const
 {
-    // Initialize protocol
-    const protoent* proto = getprotobyname("tcp");
-
-    // Check protocol
-    if (proto == nullptr)
-    {
-        throw std::runtime_error("Get protocol failed: " + std::string(strerror(errno)));
-    }
-
-    // Creating socket file descriptor
-    if ((client_socket = socket(PF_INET, SOCK_STREAM, proto->p_proto)) < 0)
+    // connect without blocking, the caller waits with a deadline
+    const int socket_fd = socket(_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (socket_fd < 0)
     {
         throw std::runtime_error("Socket creation failed: " + std::string(strerror(errno)));
     }
 
-#ifdef NON_BLOCKING
-    // Set the socket to non-blocking
-    if (fcntl(client_socket, F_SETFL, O_NONBLOCK) < 0)
-    {
-        close(client_socket);
-        throw std::runtime_error("Set socket to non-blocking failed: " + std::string(strerror(errno)));
-    }
-#endif // NON_BLOCKING
-
     // init timeval struct
     constexpr timeval wrt_timeval = {CLIENT_SOCKET_SEND_TIMEOUT, 0};
     constexpr timeval rcv_timeval = {CLIENT_SOCKET_RCV_TIMEOUT, 0};
 
-    // Setting timeout for receive
-    if (setsockopt(client_socket, SOL_SOCKET, SO_RCVTIMEO, &rcv_timeval, sizeof(rcv_timeval)) < 0)
+    // Setting timeout for receive and send
+    if (setsockopt(socket_fd, SOL_SOCKET, SO_RCVTIMEO, &rcv_timeval, sizeof(rcv_timeval)) < 0 ||
+        setsockopt(socket_fd, SOL_SOCKET, SO_SNDTIMEO, &wrt_timeval, sizeof(wrt_timeval)) < 0)
     {
-        close(client_socket);
-        throw std::runtime_error("Set socket options failed: " + std::string(strerror(errno)));
+        const std::string error = strerror(errno);
+        close(socket_fd);
+        throw std::runtime_error("Set socket options failed: " + error);
     }
 
-    // Setting timeout for send
-    if (setsockopt(client_socket, SOL_SOCKET, SO_SNDTIMEO, &wrt_timeval, sizeof(wrt_timeval)) < 0)
+    // protocol profile and local address, if configured
+    try
     {
-        close(client_socket);
-        throw std::runtime_error("Set socket options failed: " + std::string(strerror(errno)));
+        protocol->socket_options().merged(socket_options).apply(socket_fd);
+        _range_port = SourceBinding::bind(socket_fd, _family);
+    }
+    catch (const std::exception&)
+    {
+        close(socket_fd);
+        throw;
     }
+
+    return socket_fd;
 }
 
-void TCP_Client::run()
+int TCP_Client::open_socket(const SocketAddress& _address) const
 {
-    // try create socket
-    try
+    // a range port may already reach this address, the next one is tried on a new socket
+    for (size_t retries = SourceBinding::range_ports(_address.family());;)
     {
-        create_socket();
-    }
-    catch (const std::exception& e)
+        bool range_port = false;
+        const int socket_fd = create_socket(_address.family(), range_port);
+
+        if (connect(socket_fd, _address.data(), _address.length) == 0 || errno == EINPROGRESS)
+        {
+            return socket_fd;
+        }
+
+        const int error = errno;
+        close(socket_fd);
+        if (!SourceBinding::port_busy(range_port, error) || --retries == 0)
+        {
+            throw std::runtime_error(_address.to_string() + ": " + strerror(error));
+        }
+    } // for
+}
+
+void TCP_Client::connect_to(const AddressList& _addresses)
+{
+    // attempts in flight, parallel arrays for poll()
+    std::vector<pollfd> attempts;
+    std::vector<size_t> attempt_addresses;
+
+    const auto close_attempts = [&attempts, &attempt_addresses]
     {
-        throw std::runtime_error("TCP_Client::run : " + std::string(e.what()));
-    }
+        for (const pollfd& attempt : attempts)
+        {
+            close(attempt.fd);
+        }
+        attempts.clear();
+        attempt_addresses.clear();
+    };
+
+    const auto deadline = AbstractProtocol::clock::now() + std::chrono::milliseconds(CLIENT_CONNECT_TIMEOUT_MS);
+    auto next_start = AbstractProtocol::clock::now();
+    size_t next = 0;
+    std::string last_error = "no addresses";
+
+    for (;;)
+    {
+        const auto now = AbstractProtocol::clock::now();
+
+        // start the next address once the attempt delay passed or nothing is in flight
+        if (next < _addresses.size() && (now >= next_start || attempts.empty()))
+        {
+            const SocketAddress& address = _addresses[next++];
+
+            int socket_fd;
+            try
+            {
+                socket_fd = open_socket(address);
+            }
+            catch (const std::exception& e)
+            {
+                last_error = e.what();
+                continue;
+            }
+
+            attempts.push_back({socket_fd, POLLOUT, 0});
+            attempt_addresses.push_back(next - 1);
+            next_start = now + std::chrono::milliseconds(CLIENT_CONNECTION_ATTEMPT_DELAY_MS);
+            continue;
+        }
+
+        // check state
+        if (attempts.empty())
+        {
+            throw std::runtime_error("Connect failed: " + last_error);
+        }
+        if (now >= deadline)
+        {
+            close_attempts();
+            Metrics::add(Counter::TIMEOUTS);
+            throw std::runtime_error("Connect timeout");
+        }
+
+        // wait up to the deadline or the next attempt
+        auto wake = deadline;
+        if (next < _addresses.size())
+        {
+            wake = std::min(wake, next_start);
+        }
+        const auto wait = std::chrono::ceil<std::chrono::milliseconds>(wake - now);
+
+        if (poll(attempts.data(), attempts.size(), static_cast<int>(std::max<int64_t>(wait.count(), 0))) < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            const std::string error = strerror(errno);
+            close_attempts();
+            throw std::runtime_error("Poll failed: " + error);
+        }
+
+        // the first finished connect wins, failed ones make room for the next address
+        for (size_t i = 0; i < attempts.size();)
+        {
+            if (attempts[i].revents == 0)
+            {
+                ++i;
+                continue;
+            }
+
+            int error = 0;
+            socklen_t error_len = sizeof(error);
+            if (getsockopt(attempts[i].fd, SOL_SOCKET, SO_ERROR, &error, &error_len) < 0)
+            {
+                error = errno;
+            }
+
+            if (error == 0)
+            {
+                client_socket = attempts[i].fd;
+                server_address = _addresses[attempt_addresses[i]];
+
+                attempts.erase(attempts.begin() + static_cast<ptrdiff_t>(i));
+                attempt_addresses.erase(attempt_addresses.begin() + static_cast<ptrdiff_t>(i));
+                close_attempts();
+                return;
+            }
+
+            last_error = _addresses[attempt_addresses[i]].to_string() + ": " + strerror(error);
+            close(attempts[i].fd);
+            attempts.erase(attempts.begin() + static_cast<ptrdiff_t>(i));
+            attempt_addresses.erase(attempt_addresses.begin() + static_cast<ptrdiff_t>(i));
+            next_start = now;
+        }
+    } // for (;;)
+}
+
+void TCP_Client::run()
+{
+    unsigned attempt = 0;
+
+    for (;;)
+    {
+        const auto connected = AbstractProtocol::clock::now();
+
+        // a lost connection ends the run unless reconnecting is enabled
+        try
+        {
+            run_connection();
+            if (!reconnect.enabled)
+            {
+                return;
+            }
+            Logger::log<LogLevel::Error>("Connection ended, attempt:", attempt);
+        }
+        catch (const std::exception& e)
+        {
+            if (!reconnect.enabled)
+            {
+                throw;
+            }
+            Logger::log<LogLevel::Error>("Connection lost, attempt:", attempt, e.what());
+        }
 
-    // init sockaddr_in struct
-    sockaddr_in serv_addr{};
-    serv_addr.sin_family = AF_INET;
-    serv_addr.sin_port = htons(port);
-    serv_addr.sin_addr.s_addr = ip;
+        // start over after a connection that held up
+        if (ReconnectPolicy::stable(AbstractProtocol::clock::now() - connected))
+        {
+            attempt = 0;
+        }
+        if (reconnect.exhausted(attempt))
+        {
+            throw std::runtime_error("Reconnect attempts exhausted: " + std::to_string(attempt));
+        }
 
+        // back off, then wait for a connect token
+        const auto earliest = AbstractProtocol::clock::now() + reconnect.delay(attempt++);
+        std::this_thread::sleep_until(TokenBucket::connects().reserve(earliest));
+        Metrics::add(Counter::RECONNECTS);
+    } // for (;;)
+}
+
+void TCP_Client::run_connection()
+{
     // Check is port available
-    if (serv_addr.sin_port == 0)
+    if (port == 0)
     {
-        close(client_socket);
         throw std::runtime_error("Port is 0");
     }
 
-    // connect to server
-    if (connect(client_socket, reinterpret_cast<sockaddr*>(&serv_addr), sizeof(serv_addr)) != 0
-#ifdef NON_BLOCKING
-    && errno != EINPROGRESS
-#endif // NON_BLOCKING
-        )
+    // resolve (cached) and race the addresses
+    connect_to(Resolver::resolve(host, port));
+
+#ifndef NON_BLOCKING
+    // handlers use blocking I/O with socket timeouts
+    if (fcntl(client_socket, F_SETFL, fcntl(client_socket, F_GETFL) & ~O_NONBLOCK) < 0)
     {
-        close(client_socket);
-        throw std::runtime_error("Connect failed: " + std::string(strerror(errno)));
+        const std::string error = strerror(errno);
+        close_socket();
+        throw std::runtime_error("Set socket to blocking failed: " + error);
     }
+#endif // NON_BLOCKING
 
-    // initialize ip
-    char ip_s[INET_ADDRSTRLEN];
+    // print server address
+    std::cout << "Connected to server: " << server_address.to_string() << std::endl;
+    Metrics::add(Counter::CONNECTIONS_OPENED);
 
-    // check serv_addr
-    if (inet_ntop(serv_addr.sin_family, &serv_addr.sin_addr, ip_s, sizeof(ip_s)) == nullptr)
+    // the connection ends with the protocol, normally or not
+    try
     {
-        close(client_socket);
-        throw std::runtime_error("inet_ntop failed: " + std::string(strerror(errno)));
+        run_protocol();
     }
+    catch (const std::exception&)
+    {
+        close_socket();
+        Metrics::add(Counter::CONNECTIONS_CLOSED);
+        throw;
+    }
+    close_socket();
+    Metrics::add(Counter::CONNECTIONS_CLOSED);
+}
 
-    // print server ip and port
-    std::cout << "Connected to server: " << ip_s << ":" << ntohs(serv_addr.sin_port) << std::endl;
+void TCP_Client::run_protocol()
+{
+#ifdef NON_BLOCKING
+    // run event-driven protocol
+    if (protocol->supports_events())
+    {
+        event_loop();
+        return;
+    }
+#endif // NON_BLOCKING
 
     // run protocol
+    protocol->attach(client_socket);
     protocol->handler_loop(client_socket);
 }
 
-void TCP_Client::stop() const
+#ifdef NON_BLOCKING
+void TCP_Client::event_loop()
 {
-    close(client_socket);
+    protocol->on_connected(client_socket);
+
+    while (!protocol->is_closing() || protocol->wants_write())
+    {
+        pollfd poll_fd{client_socket, static_cast<short>(POLLIN | (protocol->wants_write() ? POLLOUT : 0)), 0};
+
+        // calculate timeout up to next timer
+        int timeout_ms = -1;
+        if (protocol->next_timer() != AbstractProtocol::clock::time_point{})
+        {
+            const auto wait = std::chrono::ceil<std::chrono::milliseconds>(protocol->next_timer() - AbstractProtocol::clock::now());
+            timeout_ms = static_cast<int>(std::max<int64_t>(wait.count(), 0));
+        }
+
+        const int result = poll(&poll_fd, 1, timeout_ms);
+
+        // check return value
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            throw std::runtime_error("Poll failed: " + std::string(strerror(errno)));
+        }
+
+        // dispatch io events
+        if (poll_fd.revents & (POLLIN | POLLHUP | POLLERR))
+        {
+            protocol->on_readable();
+        }
+        if ((poll_fd.revents & POLLOUT) && protocol->wants_write())
+        {
+            protocol->on_writable();
+        }
+
+        // dispatch timer
+        if (protocol->next_timer() != AbstractProtocol::clock::time_point{} && protocol->next_timer() <= AbstractProtocol::clock::now())
+        {
+            protocol->on_timer_expired();
+        }
+    } // while
+}
+#endif // NON_BLOCKING
+
+void TCP_Client::stop()
+{
+    close_socket();
+}
+
+void TCP_Client::close_socket()
+{
+    if (client_socket >= 0)
+    {
+        close(client_socket);
+        client_socket = -1;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "TimerWheel.hpp"
+
+#include <algorithm>
+
+
+TimerWheel::TimerWheel()
+{
+    // empty slots are self-linked sentinels
+    for (auto& level : slots)
+    {
+        for (TimerNode& head : level)
+        {
+            head.next = &head;
+            head.prev = &head;
+        }
+    }
+}
+
+
+void TimerWheel::link(TimerNode& head, TimerNode& node)
+{
+    node.prev = head.prev;
+    node.next = &head;
+    head.prev->next = &node;
+    head.prev = &node;
+}
+
+void TimerWheel::unlink(TimerNode& node)
+{
+    node.prev->next = node.next;
+    node.next->prev = node.prev;
+    node.next = nullptr;
+    node.prev = nullptr;
+}
+
+void TimerWheel::place(TimerNode& node)
+{
+    const uint64_t delta = node.expires - current;
+
+    // pick the lowest level whose span covers the delay
+    unsigned level = 0;
+    while (level + 1 < TIMER_WHEEL_LEVELS && delta >= (1ULL << (TIMER_WHEEL_SLOT_BITS * (level + 1))))
+    {
+        ++level;
+    }
+
+    const size_t slot = (node.expires >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+    link(slots[level][slot], node);
+}
+
+void TimerWheel::cascade(const unsigned level)
+{
+    if (level >= TIMER_WHEEL_LEVELS)
+    {
+        return;
+    }
+
+    const size_t slot = (current >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+
+    // higher levels first, their timers may land in this slot's range
+    if (slot == 0)
+    {
+        cascade(level + 1);
+    }
+
+    // re-place every timer of the slot, it is within the lower levels now
+    TimerNode& head = slots[level][slot];
+    while (head.next != &head)
+    {
+        TimerNode& node = *head.next;
+        unlink(node);
+        place(node);
+    }
+}
+
+
+void TimerWheel::schedule(TimerNode& node, uint64_t expires)
+{
+    if (node.scheduled())
+    {
+        unlink(node);
+        --count;
+    }
+
+    // past deadlines expire on the next tick, far ones are clamped to the wheel span
+    constexpr uint64_t span = (1ULL << (TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS)) - 1;
+    expires = std::max(expires, current + 1);
+    expires = std::min(expires, current + span);
+
+    node.expires = expires;
+    place(node);
+    ++count;
+}
+
+void TimerWheel::cancel(TimerNode& node)
+{
+    if (node.scheduled())
+    {
+        unlink(node);
+        --count;
+    }
+}
+
+uint64_t TimerWheel::next_expiry() const
+{
+    if (count == 0)
+    {
+        return UINT64_MAX;
+    }
+
+    // first used level 0 slot
+    for (uint64_t ticks = 1; ticks < TIMER_WHEEL_SLOTS; ++ticks)
+    {
+        const TimerNode& head = slots[0][(current + ticks) & (TIMER_WHEEL_SLOTS - 1)];
+        if (head.next != &head)
+        {
+            return ticks;
+        }
+    }
+
+    // upper level timers are not due before the next cascade
+    return TIMER_WHEEL_SLOTS - (current & (TIMER_WHEEL_SLOTS - 1));
+}
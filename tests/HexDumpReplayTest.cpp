@@ -0,0 +1,140 @@
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "ReplayProtocol.hpp"
+
+
+#define CHECK(condition) \
+    if (!(condition)) { std::cerr << __FILE__ << ":" << __LINE__ << ": " #condition << std::endl; return false; }
+
+#define TEST_SKIPPED        (77) // ctest SKIP_RETURN_CODE
+
+
+/* blocking I/O of the protocol base, the calls that write the hex log */
+class LoggedProtocol final : public AbstractProtocol
+{
+public:
+    using AbstractProtocol::send_data;
+    using AbstractProtocol::recv_data;
+
+    void handler_loop(int) override {}
+};
+
+
+/* run _body with stdout in a temporary file, returns the file */
+template <typename Body>
+static std::string capture_log(Body _body)
+{
+    char path[] = "/tmp/hex_dump_XXXXXX";
+    const int file_fd = mkstemp(path);
+    const int stdout_fd = dup(STDOUT_FILENO);
+
+    Logger::flush();
+    dup2(file_fd, STDOUT_FILENO);
+    _body();
+    Logger::flush();
+    dup2(stdout_fd, STDOUT_FILENO);
+
+    close(stdout_fd);
+    close(file_fd);
+    return path;
+}
+
+
+/* a scatter-gather send, a read and a plain send come back as three frames */
+static bool round_trip()
+{
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    const std::vector<uint8_t> header = {0xa2, 0x01, 0x02};
+    const std::vector<uint8_t> body = {0x00, 0x3c, 0x66, 0x00, 0x00, 0x01, 0x01, 0x9a};
+    const std::vector<uint8_t> reply = {0x01, 0x02, 0x03, 0x04};
+    const std::vector<uint8_t> ping = {0xa1, 0x10, 0x20, 0x30, 0x40};
+
+    LoggedProtocol protocol;
+    protocol.attach(fds[0]);
+    CHECK(write(fds[1], reply.data(), reply.size()) == static_cast<ssize_t>(reply.size()));
+
+    const std::string path = capture_log([&]
+    {
+        protocol.send_data({iovec{const_cast<uint8_t*>(header.data()), header.size()}, iovec{const_cast<uint8_t*>(body.data()), body.size()}});
+        std::vector<uint8_t> received(reply.size());
+        protocol.recv_data(received.data(), received.size());
+        protocol.send_data(ping.data(), ping.size());
+    });
+
+    const ReplayTrace trace = ReplayProtocol::load_hex_dump(path);
+    unlink(path.c_str());
+    close(fds[0]);
+    close(fds[1]);
+
+    std::vector<uint8_t> request = header;
+    request.insert(request.end(), body.begin(), body.end());
+
+    CHECK(trace.frames.size() == 3);
+    CHECK(trace.frames[0].direction == CaptureDirection::SENT && trace.frames[0].data == request);
+    CHECK(trace.frames[1].direction == CaptureDirection::RECEIVED && trace.frames[1].data == reply);
+    CHECK(trace.frames[2].direction == CaptureDirection::SENT && trace.frames[2].data == ping);
+    return true;
+}
+
+/* a frame longer than the logger keeps is refused with a pointer to captures */
+static bool truncated()
+{
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    const std::vector<uint8_t> frame(LOGGER_RECORD_PAYLOAD * 4, 0x55);
+
+    LoggedProtocol protocol;
+    protocol.attach(fds[0]);
+    const std::string path = capture_log([&] { protocol.send_data(frame.data(), frame.size()); });
+
+    std::string error;
+    try
+    {
+        ReplayProtocol::load_hex_dump(path);
+    }
+    catch (const std::exception& e)
+    {
+        error = e.what();
+    }
+    unlink(path.c_str());
+    close(fds[0]);
+    close(fds[1]);
+
+    CHECK(error.find("capture file") != std::string::npos);
+    return true;
+}
+
+
+int main()
+{
+    // hex dumps are compiled in at the debug level only
+    if (!Logger::enabled(LogLevel::Debug))
+    {
+        std::cerr << "Skipped: needs LOG_LEVEL=" << LOG_LEVEL_DEBUG << std::endl;
+        return TEST_SKIPPED;
+    }
+
+    bool ok = true;
+    try
+    {
+        ok &= round_trip();
+        ok &= truncated();
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return ok ? 0 : 1;
+}
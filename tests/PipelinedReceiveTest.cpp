@@ -0,0 +1,95 @@
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "AS3_Protocol.hpp"
+#include "Metrics.hpp"
+
+
+#define CHECK(condition) \
+    if (!(condition)) { std::cerr << __FILE__ << ":" << __LINE__ << ": " #condition << std::endl; return false; }
+
+#define HANDSHAKE_SIZE      (15U)
+#define HISTORY_SIZE        (11U)
+#define PING_SIZE           (16U)
+
+
+/*
+ * An AS3 device flushes a history window while the send is still pending
+ * (completion-based I/O, as under io_uring); the acks arrive before and
+ * after the send completes, in reads of any size.
+ */
+static bool upload_window(const size_t _events, const std::vector<size_t>& _acks_before, const std::vector<size_t>& _acks_after)
+{
+    int fds[2];
+    CHECK(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+    HistoryUpload upload;
+    upload.backlog = _events;
+    upload.window = _events;
+    AS3_Protocol device(1, upload);
+    device.set_deferred_io(true);
+    device.on_connected(fds[0]);
+
+    // handshake out, server time back
+    CHECK(device.pending_size() == HANDSHAKE_SIZE);
+    device.on_sent(device.pending_size());
+    const uint8_t server_time[4] = {0x66, 0x00, 0x00, 0x01};
+    device.on_received(server_time, sizeof(server_time));
+
+    // the whole window goes out in one send
+    CHECK(device.pending_size() == _events * HISTORY_SIZE);
+
+    const uint64_t acked = Metrics::total(Counter::HISTORY_ACKED);
+    const std::vector<uint8_t> acks(_events, 0x01);
+    size_t offset = 0;
+
+    // acks while the send is pending stay buffered
+    for (const size_t count : _acks_before)
+    {
+        device.on_received(acks.data() + offset, count);
+        offset += count;
+    }
+    device.on_sent(device.pending_size());
+
+    // and the rest while the session waits for them
+    for (const size_t count : _acks_after)
+    {
+        device.on_received(acks.data() + offset, count);
+        offset += count;
+    }
+
+    // every record acked, the first ping is on its way
+    CHECK(Metrics::total(Counter::HISTORY_ACKED) - acked == _events);
+    CHECK(device.pending_size() == PING_SIZE);
+
+    close(fds[0]);
+    close(fds[1]);
+    return true;
+}
+
+
+int main()
+{
+    bool ok = true;
+    try
+    {
+        // several acks in one read while the send is pending
+        ok &= upload_window(4, {4}, {});
+        // split across the completion
+        ok &= upload_window(4, {1, 2}, {1});
+        // all after it, one read
+        ok &= upload_window(4, {}, {4});
+        // one by one
+        ok &= upload_window(8, {}, {1, 1, 1, 1, 1, 1, 1, 1});
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << "Exception: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return ok ? 0 : 1;
+}
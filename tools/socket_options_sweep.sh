@@ -0,0 +1,68 @@
+#!/bin/sh
+#
+# Latency sweep over the socket options: runs the same fleet once per -o
+# setting and prints the fleet latency report of every run.
+#
+# usage: tools/socket_options_sweep.sh binary [setting...]
+#
+#   binary      the TCP_Client build, it connects to SERVER_DOMAIN:SERVER_PORT
+#   setting     a -o value, "" keeps the protocol profile (default list below)
+#
+# environment:
+#   DEVICES     fleet size (200)
+#   DURATION    seconds per run, above 10 to get a latency report (12)
+#   RUNS        runs per setting (2)
+#   FLEET_ARGS  the load, passed before the device count ("-e 100:1": AS3
+#               history, every record waits for its ack)
+#
+# Histograms count from the start of a run, the ramp included. Intercom
+# and AS3 pings come every 30 s, sweep them with a longer DURATION.
+
+set -u
+
+if [ $# -lt 1 ]
+then
+    echo "usage: $0 binary [setting...]" >&2
+    exit 1
+fi
+
+binary=$1
+shift
+
+devices=${DEVICES:-200}
+duration=${DURATION:-12}
+runs=${RUNS:-2}
+fleet_args=${FLEET_ARGS:--e 100:1}
+
+if [ $# -eq 0 ]
+then
+    set -- "" nodelay=0 quickack=0 sndbuf=16384 rcvbuf=16384 keepalive=1:1:3 busypoll=50 usertimeout=1000
+fi
+
+log=$(mktemp)
+trap 'rm -f "$log"' EXIT
+
+for setting in "$@"
+do
+    run=1
+    while [ "$run" -le "$runs" ]
+    do
+        echo "== -o ${setting:-(profile)}, run $run"
+
+        # the fleet runs until stopped, the report of the last 10 s tick is the result
+        if [ -n "$setting" ]
+        then
+            # shellcheck disable=SC2086
+            timeout "$duration" "$binary" -o "$setting" $fleet_args "$devices" > "$log" 2>&1
+        else
+            # shellcheck disable=SC2086
+            timeout "$duration" "$binary" $fleet_args "$devices" > "$log" 2>&1
+        fi
+
+        # last block of latency lines, and how the fleet fared
+        awk '/^Latency/ { if (!open) { block = ""; open = 1 } block = block $0 "\n"; next } { open = 0 } END { printf "%s", block }' "$log"
+        grep '^Fleet:' "$log" | tail -n 1
+
+        run=$((run + 1))
+    done
+done
@@ -1,7 +1,6 @@
 #pragma once
 
-#include <sstream>
-#include <iomanip>
+#include <algorithm>
 #include <poll.h>
 #include <sys/types.h>
 #include <sys/socket.h>
@@ -12,42 +11,19 @@
 constexpr int RECV_FLAGS = 0; // Replace it with actual flags if needed
 constexpr int SEND_FLAGS = 0; // Replace it with actual flags if needed
 
-constexpr size_t CHUNK_SIZE = 256U; // Replace it with actual value
+constexpr int IO_WAIT_TIMEOUT_MS = 30000; // timeout for non-blocking sockets
 
 
 template <typename T>
 void AbstractProtocol::log_buffer_hex(T buffer, const size_t size)
 {
-    std::ostringstream hex_stream;
-    hex_stream << std::hex << std::setfill('0');
-    for (size_t i = 0; i < size; ++i)
-    {
-        hex_stream << std::setw(2) << static_cast<unsigned int>(static_cast<unsigned char>(buffer[i])) << " ";
-    }
-
-    // Log the hexadecimal representation
-    std::cout << "Data: " << hex_stream.str() << std::endl;
+    // formatted by the logger thread, compiled out below debug level
+    Logger::log_hex<LogLevel::Debug>("Data:", buffer, size);
 }
 
 template <typename T>
 ssize_t AbstractProtocol::recv_data(T data, size_t size)
 {
-    std::cout << "Reading " << size << " bytes data ..." << std::endl;
-
-    ssize_t bytes_received = 0;
-    ssize_t result;
-    size_t block_size = CHUNK_SIZE;
-
-    // check size
-    if (size == 0)
-    {
-        throw std::invalid_argument("Invalid size");
-    }
-    if (size > static_cast<size_t>(INT_MAX))
-    {
-        throw std::out_of_range("Size too big");
-    }
-
     // Check buffer (only if T is a pointer)
     if constexpr (std::is_pointer_v<T>)
     {
@@ -61,71 +37,27 @@ ssize_t AbstractProtocol::recv_data(T data, size_t size)
         throw std::invalid_argument("Buffer must be a pointer");
     }
 
+    // read message and copy it out of the receive buffer
+    const std::span<const uint8_t> frame = recv_view(size);
+    std::memcpy(reinterpret_cast<uint8_t*>(data), frame.data(), frame.size());
+    rx_buffer.consume(frame.size());
 
-    while (bytes_received < static_cast<ssize_t>(size))
-    {
-        // Calculate bytes to read
-        block_size = std::min(block_size, size - bytes_received);
-
-        // check block size
-        if (block_size == 0)
-        {
-            throw std::logic_error("Invalid block size");
-        }
-
-        // rcv data
-        result = recv(socket_fd, reinterpret_cast<char*>(data) + bytes_received, block_size, RECV_FLAGS);
-
-        // check return value
-        if (result == 0)
-        {
-            break;
-        }
-        else if (result < 0)
-        {
-            switch (errno)
-            {
-                case EINTR:
-                    std::cout << "Interrupted system call, retrying..." << std::endl;
-                    continue;
-
-                case EAGAIN:
-                    throw std::runtime_error("Resource temporarily unavailable: timeout !!");
-
-                default:
-                    throw std::runtime_error("Error receiving data: " + std::string(strerror(errno)));
-            }
-        }
-        else
-        {
-            bytes_received += result;
-        }
-    } // while
-
-    // check bytes received
-    if (bytes_received <= 0 || bytes_received > INT_MAX)
-    {
-        throw std::out_of_range("Invalid bytes received: " + std::to_string(bytes_received));
-    }
-    if (bytes_received != static_cast<ssize_t>(size))
-    {
-        throw std::runtime_error("Reading data failed, received: " + std::to_string(bytes_received));
-    }
-
-    // log data
-    log_buffer_hex(data, bytes_received);
-
-    return bytes_received;
+    return static_cast<ssize_t>(frame.size());
 }
 
 template <typename T>
 ssize_t AbstractProtocol::send_data(T data, size_t size)
 {
-    std::cout << "Sending " << size << " bytes data ..." << std::endl;
+    // send deferred data together with this one
+    if (!tx_deferred.empty())
+    {
+        return send_data({iovec{const_cast<void*>(reinterpret_cast<const void*>(data)), size}});
+    }
+
+    Logger::log<LogLevel::Debug>("Sending bytes:", size);
 
     ssize_t bytes_sent = 0;
     ssize_t result;
-    size_t block_size = CHUNK_SIZE;
 
     // check size
     if (size == 0)
@@ -153,17 +85,8 @@ ssize_t AbstractProtocol::send_data(T data, size_t size)
 
     while (bytes_sent < static_cast<ssize_t>(size))
     {
-        // Calculate bytes to read
-        block_size = std::min(block_size, size - bytes_sent);
-
-        // check block size
-        if (block_size == 0)
-        {
-            throw std::logic_error("Invalid block size");
-        }
-
-        // send data
-        result = send(socket_fd, reinterpret_cast<const char*>(data) + bytes_sent, block_size, SEND_FLAGS);
+        // send everything left, the kernel takes as much as fits
+        result = send(socket_fd, reinterpret_cast<const char*>(data) + bytes_sent, size - bytes_sent, SEND_FLAGS);
 
         // check return value
         if (result == 0)
@@ -175,11 +98,17 @@ ssize_t AbstractProtocol::send_data(T data, size_t size)
             switch (errno)
             {
                 case EINTR:
-                    std::cout << "Interrupted system call, retrying..." << std::endl;
+                    Logger::log<LogLevel::Debug>("Interrupted system call, retrying...");
                     continue;
 
                 case EAGAIN:
+#ifdef NON_BLOCKING
+                    // wait until the socket is writable
+                    wait_socket(POLLOUT, IO_WAIT_TIMEOUT_MS);
+                    continue;
+#else
                     throw std::runtime_error("Resource temporarily unavailable: timeout !!");
+#endif // NON_BLOCKING
 
                 default:
                     throw std::runtime_error("Error sending data: " + std::string(strerror(errno)));
@@ -203,6 +132,8 @@ ssize_t AbstractProtocol::send_data(T data, size_t size)
 
     // log data
     log_buffer_hex(data, bytes_sent);
+    const iovec part{const_cast<void*>(reinterpret_cast<const void*>(data)), static_cast<size_t>(bytes_sent)};
+    record_frame(CaptureDirection::SENT, &part, 1);
 
     return bytes_sent;
 }
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+
+template <typename T>
+T wire_load(const uint8_t* _data)
+{
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        static_assert(sizeof(T) == sizeof(uint32_t) || sizeof(T) == sizeof(uint64_t), "IEEE single or double only");
+        return std::bit_cast<T>(wire_load<std::conditional_t<sizeof(T) == sizeof(uint32_t), uint32_t, uint64_t>>(_data));
+    }
+    else
+    {
+        static_assert(std::is_unsigned_v<T> && sizeof(T) <= sizeof(uint64_t), "Unsigned integers only");
+
+        T value;
+        std::memcpy(&value, _data, sizeof(T));
+        if constexpr (sizeof(T) > 1 && std::endian::native == std::endian::little)
+        {
+            if constexpr (sizeof(T) == 2) { value = __builtin_bswap16(value); }
+            if constexpr (sizeof(T) == 4) { value = __builtin_bswap32(value); }
+            if constexpr (sizeof(T) == 8) { value = __builtin_bswap64(value); }
+        }
+        return value;
+    }
+}
+
+template <typename T>
+void wire_store(uint8_t* _data, T _value)
+{
+    if constexpr (std::is_floating_point_v<T>)
+    {
+        static_assert(sizeof(T) == sizeof(uint32_t) || sizeof(T) == sizeof(uint64_t), "IEEE single or double only");
+        wire_store(_data, std::bit_cast<std::conditional_t<sizeof(T) == sizeof(uint32_t), uint32_t, uint64_t>>(_value));
+    }
+    else
+    {
+        static_assert(std::is_unsigned_v<T> && sizeof(T) <= sizeof(uint64_t), "Unsigned integers only");
+
+        if constexpr (sizeof(T) > 1 && std::endian::native == std::endian::little)
+        {
+            if constexpr (sizeof(T) == 2) { _value = __builtin_bswap16(_value); }
+            if constexpr (sizeof(T) == 4) { _value = __builtin_bswap32(_value); }
+            if constexpr (sizeof(T) == 8) { _value = __builtin_bswap64(_value); }
+        }
+        std::memcpy(_data, &_value, sizeof(T));
+    }
+}
+
+
+template <typename T, T Value>
+template <typename Object>
+const uint8_t* WireConst<T, Value>::get(const uint8_t* _cursor, const uint8_t*&, Object&)
+{
+    const T value = wire_load<T>(_cursor);
+    if (value != Value)
+    {
+        throw std::runtime_error("Invalid start byte: " + std::to_string(value) + " != " + std::to_string(Value));
+    }
+    return _cursor + size;
+}
+
+
+template <auto Member, typename T, unsigned Scale>
+template <typename Object>
+uint8_t* WireScaled<Member, T, Scale>::put(uint8_t* _cursor, const Object& _object)
+{
+    wire_store<T>(_cursor, static_cast<T>(std::lround(_object.*Member * Scale)));
+    return _cursor + size;
+}
+
+template <auto Member, typename T, unsigned Scale>
+template <typename Object>
+const uint8_t* WireScaled<Member, T, Scale>::get(const uint8_t* _cursor, const uint8_t*&, Object& _object)
+{
+    using Type = typename WireMember<Member>::type;
+    _object.*Member = static_cast<Type>(wire_load<T>(_cursor)) / static_cast<Type>(Scale);
+    return _cursor + size;
+}
+
+
+template <auto... Members>
+template <typename Object>
+uint8_t* WireFlags<Members...>::put(uint8_t* _cursor, const Object& _object)
+{
+    uint8_t flags = 0;
+    unsigned bit = 0;
+    ((flags |= static_cast<uint8_t>(static_cast<bool>(_object.*Members) << bit++)), ...);
+
+    *_cursor = flags;
+    return _cursor + size;
+}
+
+template <auto... Members>
+template <typename Object>
+const uint8_t* WireFlags<Members...>::get(const uint8_t* _cursor, const uint8_t*&, Object& _object)
+{
+    const uint8_t flags = *_cursor;
+    unsigned bit = 0;
+    ((_object.*Members = static_cast<typename WireMember<Members>::type>((flags >> bit++) & 0x01U)), ...);
+
+    return _cursor + size;
+}
+
+
+template <auto Member, size_t MaxSize, char Delimiter>
+template <typename Object>
+uint8_t* WireText<Member, MaxSize, Delimiter>::put(uint8_t* _cursor, const Object& _object)
+{
+    const std::string& text = _object.*Member;
+    const size_t length = std::min(text.size(), MaxSize);
+
+    std::memcpy(_cursor, text.data(), length);
+    _cursor += length;
+
+    // the decoder stops at MaxSize without looking for a delimiter
+    if (length < MaxSize)
+    {
+        *_cursor++ = static_cast<uint8_t>(Delimiter);
+    }
+    return _cursor;
+}
+
+template <auto Member, size_t MaxSize, char Delimiter>
+template <typename Object>
+const uint8_t* WireText<Member, MaxSize, Delimiter>::get(const uint8_t* _cursor, const uint8_t*& _end, Object& _object)
+{
+    std::string& text = _object.*Member;
+    text.clear();
+
+    // up to the delimiter or MaxSize bytes
+    const size_t available = std::min<size_t>(_end - _cursor, MaxSize);
+    const auto* delimiter = static_cast<const uint8_t*>(std::memchr(_cursor, Delimiter, available));
+    if (delimiter != nullptr)
+    {
+        text.assign(reinterpret_cast<const char*>(_cursor), delimiter - _cursor);
+        return delimiter + 1;
+    }
+    if (available < MaxSize)
+    {
+        throw std::runtime_error("Packet is truncated in a text field");
+    }
+
+    text.assign(reinterpret_cast<const char*>(_cursor), MaxSize);
+    return _cursor + MaxSize;
+}
+
+
+template <typename T>
+template <typename Object>
+const uint8_t* WireLength<T>::get(const uint8_t* _cursor, const uint8_t*& _end, Object&)
+{
+    const T length = wire_load<T>(_cursor);
+    _cursor += size;
+
+    if (length > static_cast<size_t>(_end - _cursor))
+    {
+        throw std::runtime_error("Packet is truncated: " + std::to_string(_end - _cursor) + " < " + std::to_string(length));
+    }
+
+    // the rest of the packet ends here
+    _end = _cursor + length;
+    return _cursor;
+}
+
+template <typename T>
+void WireLength<T>::finish(uint8_t*, uint8_t* _field, const uint8_t* _end)
+{
+    wire_store<T>(_field, static_cast<T>(_end - _field - size));
+}
+
+
+template <auto Member, typename Count, size_t MaxCount, typename... Fields>
+template <typename Object>
+uint8_t* WireRepeated<Member, Count, MaxCount, Fields...>::put(uint8_t* _cursor, const Object& _object)
+{
+    const auto& elements = _object.*Member;
+    if (elements.size() > MaxCount)
+    {
+        throw std::length_error("Too many elements: " + std::to_string(elements.size()) + " > " + std::to_string(MaxCount));
+    }
+
+    wire_store<Count>(_cursor, static_cast<Count>(elements.size()));
+    _cursor += sizeof(Count);
+
+    for (const auto& element : elements)
+    {
+        _cursor = Element::put(_cursor, element);
+    }
+    return _cursor;
+}
+
+template <auto Member, typename Count, size_t MaxCount, typename... Fields>
+template <typename Object>
+const uint8_t* WireRepeated<Member, Count, MaxCount, Fields...>::get(const uint8_t* _cursor, const uint8_t*& _end, Object& _object)
+{
+    if (_end - _cursor < static_cast<ptrdiff_t>(sizeof(Count)))
+    {
+        throw std::runtime_error("Packet is truncated in an element count");
+    }
+
+    const Count count = wire_load<Count>(_cursor);
+    _cursor += sizeof(Count);
+    if (count > MaxCount)
+    {
+        throw std::runtime_error("Invalid element count: " + std::to_string(count));
+    }
+
+    auto& elements = _object.*Member;
+    elements.clear();
+    elements.resize(count);
+
+    for (auto& element : elements)
+    {
+        // a fixed element reads without checks of its own
+        if constexpr (Element::fixed)
+        {
+            if (static_cast<size_t>(_end - _cursor) < Element::size)
+            {
+                throw std::runtime_error("Packet is truncated in an element");
+            }
+        }
+        _cursor = Element::get(_cursor, _end, element);
+    }
+    return _cursor;
+}
+
+
+template <typename... Fields>
+template <typename Object>
+size_t WirePacket<Fields...>::encode(uint8_t* _buffer, const Object& _object)
+{
+    // write the fields, remembering where each one starts
+    std::array<uint8_t*, sizeof...(Fields)> positions{};
+    uint8_t* cursor = _buffer;
+    size_t index = 0;
+    ((positions[index++] = cursor, cursor = Fields::put(cursor, _object)), ...);
+
+    // then the fields that depend on the others, in order: the length before the checksum
+    index = 0;
+    (Fields::finish(_buffer, positions[index++], cursor), ...);
+
+    return cursor - _buffer;
+}
+
+template <typename... Fields>
+template <typename Object>
+size_t WirePacket<Fields...>::decode(const std::span<const uint8_t> _packet, Object& _object)
+{
+    // a fixed packet is checked once, the fields read without checks
+    if constexpr (fixed)
+    {
+        if (_packet.size() < size)
+        {
+            throw std::runtime_error("Packet is truncated: " + std::to_string(_packet.size()) + " < " + std::to_string(size));
+        }
+    }
+
+    const uint8_t* end = _packet.data() + (fixed ? size : _packet.size());
+    return get(_packet.data(), end, _object) - _packet.data();
+}
+
+template <typename... Fields>
+template <typename Object>
+const uint8_t* WirePacket<Fields...>::get(const uint8_t* _cursor, const uint8_t*& _end, Object& _object)
+{
+    ((_cursor = get_field<Fields>(_cursor, _end, _object)), ...);
+    return _cursor;
+}
+
+template <typename... Fields>
+template <typename Field, typename Object>
+const uint8_t* WirePacket<Fields...>::get_field(const uint8_t* _cursor, const uint8_t*& _end, Object& _object)
+{
+    // variable packets check each fixed field, variable fields check themselves
+    if constexpr (!fixed && Field::fixed)
+    {
+        if (static_cast<size_t>(_end - _cursor) < Field::size)
+        {
+            throw std::runtime_error("Packet is truncated: " + std::to_string(_end - _cursor) + " < " + std::to_string(Field::size));
+        }
+    }
+
+    return Field::get(_cursor, _end, _object);
+}
+
+
+template <typename... Fields>
+template <typename Field>
+constexpr size_t WirePacket<Fields...>::offset_of()
+{
+    static_assert((std::is_same_v<Field, Fields> || ...), "Field is not in the packet");
+
+    // sum the sizes up to the first match
+    size_t offset = 0;
+    bool found = false;
+    ((found = found || std::is_same_v<Field, Fields>, offset += found ? 0 : Fields::size), ...);
+    return offset;
+}
+
+
+template <typename Packet>
+template <typename Field, typename Object>
+void WireTemplate<Packet>::patch(const Object& _object)
+{
+    constexpr size_t offset = Packet::template offset_of<Field>();
+    constexpr size_t checksum_offset = Packet::size - WireChecksum::size;
+    static_assert(offset + Field::size <= checksum_offset, "The checksum follows the fields, it is not patched");
+
+    uint8_t* field = bytes.data() + offset;
+
+    // the checksum is a plain byte sum: drop the old bytes, add the new ones
+    uint32_t removed = 0;
+    uint32_t added = 0;
+    for (size_t i = 0; i < Field::size; ++i)
+    {
+        removed += field[i];
+    }
+    Field::put(field, _object);
+    for (size_t i = 0; i < Field::size; ++i)
+    {
+        added += field[i];
+    }
+
+    const uint16_t checksum = wire_load<uint16_t>(bytes.data() + checksum_offset);
+    wire_store<uint16_t>(bytes.data() + checksum_offset, static_cast<uint16_t>(checksum + added - removed));
+}
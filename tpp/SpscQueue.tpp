@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <stdexcept>
+
+
+template <typename T>
+SpscQueue<T>::SpscQueue(const size_t _capacity) :
+    slots(std::make_unique<T[]>(std::bit_ceil(std::max<size_t>(_capacity, 2)))),
+    mask(std::bit_ceil(std::max<size_t>(_capacity, 2)) - 1)
+{
+    // check capacity
+    if (_capacity == 0)
+    {
+        throw std::invalid_argument("Queue capacity must be positive");
+    }
+}
+
+template <typename T>
+bool SpscQueue<T>::try_push(T&& _value)
+{
+    const size_t position = tail.load(std::memory_order_relaxed);
+
+    // check free space, reload the consumer position only when the cached one says full
+    if (position - cached_head > mask)
+    {
+        cached_head = head.load(std::memory_order_acquire);
+        if (position - cached_head > mask)
+        {
+            return false;
+        }
+    }
+
+    slots[position & mask] = std::move(_value);
+
+    // publish
+    tail.store(position + 1, std::memory_order_release);
+
+    return true;
+}
+
+template <typename T>
+bool SpscQueue<T>::try_pop(T& _value)
+{
+    const size_t position = head.load(std::memory_order_relaxed);
+
+    // check data, reload the producer position only when the cached one says empty
+    if (position == cached_tail)
+    {
+        cached_tail = tail.load(std::memory_order_acquire);
+        if (position == cached_tail)
+        {
+            return false;
+        }
+    }
+
+    _value = std::move(slots[position & mask]);
+
+    // release the slot
+    head.store(position + 1, std::memory_order_release);
+
+    return true;
+}
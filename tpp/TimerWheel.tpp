@@ -0,0 +1,35 @@
+#pragma once
+
+
+template <typename Callback>
+void TimerWheel::advance(const uint64_t _now, Callback&& _callback)
+{
+    while (current < _now)
+    {
+        // nothing scheduled, jump ahead
+        if (count == 0)
+        {
+            current = _now;
+            return;
+        }
+
+        ++current;
+
+        // move upper level timers down when level 0 wraps
+        if ((current & (TIMER_WHEEL_SLOTS - 1)) == 0)
+        {
+            cascade(1);
+        }
+
+        // expire the current slot
+        TimerNode& head = slots[0][current & (TIMER_WHEEL_SLOTS - 1)];
+        while (head.next != &head)
+        {
+            TimerNode& node = *head.next;
+            unlink(node);
+            --count;
+
+            _callback(node);
+        }
+    }
+}